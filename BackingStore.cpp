@@ -0,0 +1,133 @@
+#include "BackingStore.h"
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+BackingStore::~BackingStore() {
+    close();
+}
+
+bool BackingStore::open(const std::string& filePath, size_t size) {
+    close();
+    path = filePath;
+    slotSize = size;
+#ifdef _WIN32
+    HANDLE h = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+        std::cerr << "Error: Cannot create backing store '" << path << "'\n";
+        return false;
+    }
+    file = h;
+#else
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Error: Cannot create backing store '" << path << "'\n";
+        return false;
+    }
+#endif
+    if (!map(INITIAL_SLOTS)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void BackingStore::close() {
+    unmap();
+#ifdef _WIN32
+    if (file) CloseHandle(static_cast<HANDLE>(file));
+    file = nullptr;
+#else
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+#endif
+    capacity = 0;
+    inUse = 0;
+    freeSlots.clear();
+}
+
+// Maps the first `slots` slots of the file, extending it first if needed.
+// The old mapping, if any, stays in place until the new one exists, so a failed
+// remap leaves every slot readable.
+bool BackingStore::map(size_t slots) {
+    size_t bytes = slots * slotSize;
+#ifdef _WIN32
+    HANDLE m = CreateFileMappingA(static_cast<HANDLE>(file), nullptr, PAGE_READWRITE,
+        static_cast<DWORD>(static_cast<uint64_t>(bytes) >> 32), static_cast<DWORD>(bytes), nullptr);
+    if (!m) {
+        std::cerr << "Error: Cannot map backing store '" << path << "'\n";
+        return false;
+    }
+    void* view = MapViewOfFile(m, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (!view) {
+        CloseHandle(m);
+        std::cerr << "Error: Cannot map backing store '" << path << "'\n";
+        return false;
+    }
+    unmap();
+    mapping = m;
+    base = static_cast<uint8_t*>(view);
+#else
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        std::cerr << "Error: Cannot grow backing store '" << path << "'\n";
+        return false;
+    }
+    void* view = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        std::cerr << "Error: Cannot map backing store '" << path << "'\n";
+        return false;
+    }
+    unmap();
+    base = static_cast<uint8_t*>(view);
+#endif
+    for (size_t s = slots; s-- > capacity; ) freeSlots.push_back(static_cast<int32_t>(s));
+    capacity = slots;
+    return true;
+}
+
+void BackingStore::unmap() {
+    if (!base) return;
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+    CloseHandle(static_cast<HANDLE>(mapping));
+    mapping = nullptr;
+#else
+    munmap(base, capacity * slotSize);
+#endif
+    base = nullptr;
+}
+
+int32_t BackingStore::allocateSlot() {
+    if (freeSlots.empty()) {
+        // the slot contents live in the file, so remapping at double size keeps them
+        if (!map(capacity * 2)) return -1;
+    }
+    int32_t slot = freeSlots.back();
+    freeSlots.pop_back();
+    inUse++;
+    return slot;
+}
+
+void BackingStore::freeSlot(int32_t slot) {
+    if (slot < 0) return;
+    freeSlots.push_back(slot);
+    inUse--;
+}
+
+void BackingStore::write(int32_t slot, const uint8_t* page) {
+    std::memcpy(base + static_cast<size_t>(slot) * slotSize, page, slotSize);
+}
+
+void BackingStore::read(int32_t slot, uint8_t* page) const {
+    std::memcpy(page, base + static_cast<size_t>(slot) * slotSize, slotSize);
+}
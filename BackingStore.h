@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Page-sized slots in a memory-mapped file. Evicted pages are copied into a slot and
+// read back on the next fault; the file grows by doubling when every slot is taken.
+// Scheduler thread only.
+class BackingStore {
+public:
+    BackingStore() = default;
+    ~BackingStore();
+    BackingStore(const BackingStore&) = delete;
+    BackingStore& operator=(const BackingStore&) = delete;
+
+    bool open(const std::string& path, size_t slotSize); // truncates the file
+    void close();
+    bool isOpen() const { return base != nullptr; }
+
+    int32_t allocateSlot(); // -1 when the file cannot grow
+    void freeSlot(int32_t slot);
+    void write(int32_t slot, const uint8_t* page);
+    void read(int32_t slot, uint8_t* page) const;
+
+    size_t getSlotSize() const { return slotSize; }
+    size_t getSlotsInUse() const { return inUse; }
+    size_t getCapacity() const { return capacity; }
+    const std::string& getPath() const { return path; }
+
+private:
+    static constexpr size_t INITIAL_SLOTS = 64;
+
+    std::string path;
+    size_t slotSize = 0;
+    size_t capacity = 0; // slots the mapping currently covers
+    size_t inUse = 0;
+    std::vector<int32_t> freeSlots;
+    uint8_t* base = nullptr;
+#ifdef _WIN32
+    void* file = nullptr;    // HANDLE
+    void* mapping = nullptr; // HANDLE
+#else
+    int fd = -1;
+#endif
+
+    bool map(size_t slots);
+    void unmap();
+};
@@ -0,0 +1,523 @@
+#include "Checkpoint.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "MemoryManager.h"
+#include "Process.h"
+#include "Scheduler.h"
+#include "ScreenManager.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// File layout (native little-endian; strings are a u16 length and the bytes):
+//   header     magic[8] "CSCKPT\r\n", u32 version, u32 page size, u64 process count,
+//              u64 file size
+//   scheduler  u64 tick, i32 next process id, i32 tick counter, u8 running,
+//              u64 paused arrivals, u64 finished, u64 total waiting, u64 total turnaround
+//   frames     u64 next load seq, u32 + (u64 load seq, u64 last use, u8 pinned),
+//              u32 + free frames
+//   processes  name, u64 line, u8 finished, u8 manual, i8 FOR level, u8 body pending,
+//              i32 FOR counters[4], SchedInfo fields, u32 + instructions (u8 type,
+//              u8 argc, args), u32 + variables (name, u16), u32 + logs,
+//              u32 memory size, u32 + pages (u32 index, i32 frame, page bytes)
+//   queues     u32 + (i32 core, u32 index, i64 budget, i32 delay, u8 reason) on cores,
+//              policy name, u64 placement cursor, u32 + (u32 index, i32 queue, i32 level)
+//              ready, u32 + (u32 index, u64 wake tick) sleepers
+
+std::thread Checkpoint::writer;
+
+namespace {
+    constexpr char MAGIC[8] = { 'C', 'S', 'C', 'K', 'P', 'T', '\r', '\n' };
+    constexpr size_t FILE_SIZE_OFFSET = 8 + 4 + 4 + 8;
+    constexpr int PROCESSES_PER_ARENA = 16;
+
+    // What save() copies on the scheduler thread. Names, instructions and logs are left
+    // in the processes: they never change once written, and restore() waits for us.
+    struct Image {
+        SchedulerState sched;
+        MemoryState memory;
+        std::vector<Process*> processes;
+        std::vector<ProcessState> states;
+        std::vector<uint32_t> memSize;
+        std::vector<size_t> pageBegin; // per process into pageIndex, plus the end
+        std::vector<uint32_t> pageIndex;
+        std::vector<int32_t> pageFrame;
+        std::vector<uint8_t> pageData;
+        uint32_t pageSize = 0;
+    };
+
+    class Writer {
+    public:
+        explicit Writer(std::ofstream& out) : out(out) { buf.reserve(FLUSH_AT + 4096); }
+
+        template <class T> void put(T v) {
+            size_t at = buf.size();
+            buf.resize(at + sizeof(T));
+            std::memcpy(&buf[at], &v, sizeof(T));
+        }
+        void bytes(const void* p, size_t n) {
+            const char* c = static_cast<const char*>(p);
+            buf.insert(buf.end(), c, c + n);
+            if (buf.size() >= FLUSH_AT) flush();
+        }
+        void str(std::string_view s) {
+            put(static_cast<uint16_t>(s.size()));
+            bytes(s.data(), s.size());
+        }
+        void flush() {
+            out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+            written += buf.size();
+            buf.clear();
+        }
+        uint64_t size() const { return written + buf.size(); }
+
+    private:
+        static constexpr size_t FLUSH_AT = 1 << 20;
+        std::ofstream& out;
+        std::vector<char> buf;
+        uint64_t written = 0;
+    };
+
+    class Reader {
+    public:
+        Reader(const uint8_t* p, size_t n) : p(p), end(p + n) {}
+
+        template <class T> T get() {
+            need(sizeof(T));
+            T v;
+            std::memcpy(&v, p, sizeof(T));
+            p += sizeof(T);
+            return v;
+        }
+        const uint8_t* bytes(size_t n) {
+            need(n);
+            const uint8_t* at = p;
+            p += n;
+            return at;
+        }
+        std::string_view str() {
+            uint16_t n = get<uint16_t>();
+            return std::string_view(reinterpret_cast<const char*>(bytes(n)), n);
+        }
+
+    private:
+        const uint8_t* p;
+        const uint8_t* end;
+
+        void need(size_t n) const {
+            if (static_cast<size_t>(end - p) < n) throw std::runtime_error("file is truncated");
+        }
+    };
+
+    // Read-only view of a whole file.
+    class MappedFile {
+    public:
+        ~MappedFile() { close(); }
+
+        bool open(const std::string& path) {
+#ifdef _WIN32
+            HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (f == INVALID_HANDLE_VALUE) return false;
+            file = f;
+            LARGE_INTEGER n;
+            if (!GetFileSizeEx(f, &n) || n.QuadPart == 0) return false;
+            size = static_cast<size_t>(n.QuadPart);
+            mapping = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!mapping) return false;
+            void* view = MapViewOfFile(static_cast<HANDLE>(mapping), FILE_MAP_READ, 0, 0, 0);
+            if (!view) return false;
+#else
+            fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) return false;
+            struct stat st;
+            if (fstat(fd, &st) != 0 || st.st_size == 0) return false;
+            size = static_cast<size_t>(st.st_size);
+            void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view == MAP_FAILED) return false;
+#endif
+            data = static_cast<const uint8_t*>(view);
+            return true;
+        }
+
+        void close() {
+#ifdef _WIN32
+            if (data) UnmapViewOfFile(data);
+            if (mapping) CloseHandle(static_cast<HANDLE>(mapping));
+            if (file) CloseHandle(static_cast<HANDLE>(file));
+            mapping = nullptr;
+            file = nullptr;
+#else
+            if (data) munmap(const_cast<uint8_t*>(data), size);
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+#endif
+            data = nullptr;
+        }
+
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+
+    private:
+#ifdef _WIN32
+        void* file = nullptr;    // HANDLE
+        void* mapping = nullptr; // HANDLE
+#else
+        int fd = -1;
+#endif
+    };
+
+    // Scheduler thread: the cut itself.
+    void capture(Image& img) {
+        Scheduler::captureState(img.sched);
+        MemoryManager::saveFrames(img.memory);
+        img.processes = ScreenManager::getProcesses();
+        img.pageSize = MemoryManager::getFrameSize();
+        size_t n = img.processes.size();
+        img.states.resize(n);
+        img.memSize.resize(n);
+        img.pageBegin.reserve(n + 1);
+        for (size_t i = 0; i < n; ++i) {
+            Process* p = img.processes[i];
+            p->saveState(img.states[i]);
+            img.memSize[i] = p->getMemory().size;
+            img.pageBegin.push_back(img.pageIndex.size());
+            MemoryManager::savePages(p->getMemory(), img.pageIndex, img.pageFrame, img.pageData);
+        }
+        img.pageBegin.push_back(img.pageIndex.size());
+    }
+
+    void writeImage(const Image& img, std::ofstream& out, Writer& w) {
+        w.bytes(MAGIC, sizeof(MAGIC));
+        w.put<uint32_t>(Checkpoint::VERSION);
+        w.put<uint32_t>(img.pageSize);
+        w.put<uint64_t>(img.processes.size());
+        w.put<uint64_t>(0); // file size, patched at the end
+
+        const SchedulerState& s = img.sched;
+        w.put<uint64_t>(s.tick);
+        w.put<int32_t>(s.nextProcessId);
+        w.put<int32_t>(s.tickCounter);
+        w.put<uint8_t>(s.running);
+        w.put<uint64_t>(s.pausedArrivals);
+        w.put<uint64_t>(s.finishedCount);
+        w.put<uint64_t>(s.totalWaiting);
+        w.put<uint64_t>(s.totalTurnaround);
+
+        w.put<uint64_t>(img.memory.nextLoadSeq);
+        w.put<uint32_t>(static_cast<uint32_t>(img.memory.frames.size()));
+        for (const MemoryState::FrameInfo& f : img.memory.frames) {
+            w.put<uint64_t>(f.loadSeq);
+            w.put<uint64_t>(f.lastUse);
+            w.put<uint8_t>(f.pinned);
+        }
+        w.put<uint32_t>(static_cast<uint32_t>(img.memory.freeFrames.size()));
+        for (int32_t f : img.memory.freeFrames) w.put<int32_t>(f);
+
+        std::unordered_map<const Process*, uint32_t> index;
+        index.reserve(img.processes.size());
+        for (size_t i = 0; i < img.processes.size(); ++i) {
+            const Process* p = img.processes[i];
+            const ProcessState& st = img.states[i];
+            index.emplace(p, static_cast<uint32_t>(i));
+
+            w.str(p->getName());
+            w.put<uint64_t>(st.current_line);
+            w.put<uint8_t>(st.finished);
+            w.put<uint8_t>(st.manual);
+            w.put<int8_t>(static_cast<int8_t>(st.for_level));
+            w.put<uint8_t>(st.for_body_pending);
+            for (int it : st.for_iter) w.put<int32_t>(it);
+
+            const SchedInfo& si = st.sched;
+            w.put<uint32_t>(si.pid);
+            w.put<int32_t>(si.priority);
+            w.put<int32_t>(si.level);
+            w.put<uint64_t>(si.boost_epoch);
+            w.put<uint64_t>(si.seq);
+            w.put<uint64_t>(si.arrival_tick);
+            w.put<uint64_t>(si.ready_since);
+            w.put<uint64_t>(si.waiting_ticks);
+            w.put<int32_t>(si.last_core);
+
+            const InstructionList& ins = p->getInstructions();
+            w.put<uint32_t>(static_cast<uint32_t>(ins.size()));
+            for (const Instruction& instr : ins) {
+                w.put<uint8_t>(static_cast<uint8_t>(instr.type));
+                w.put<uint8_t>(static_cast<uint8_t>(instr.args.size()));
+                for (const std::string& a : instr.args) w.str(a);
+            }
+
+            w.put<uint32_t>(static_cast<uint32_t>(st.variables.size()));
+            for (const auto& [var, value] : st.variables) {
+                w.str(var);
+                w.put<uint16_t>(value);
+            }
+
+            // append-only: every line up to the saved count is already complete
+            std::vector<std::string> logs = p->getLogs(st.log_count);
+            w.put<uint32_t>(static_cast<uint32_t>(logs.size()));
+            for (const std::string& line : logs) w.str(line);
+
+            w.put<uint32_t>(img.memSize[i]);
+            size_t first = img.pageBegin[i];
+            size_t last = img.pageBegin[i + 1];
+            w.put<uint32_t>(static_cast<uint32_t>(last - first));
+            for (size_t pg = first; pg < last; ++pg) {
+                w.put<uint32_t>(img.pageIndex[pg]);
+                w.put<int32_t>(img.pageFrame[pg]);
+                w.bytes(&img.pageData[pg * img.pageSize], img.pageSize);
+            }
+        }
+
+        w.put<uint32_t>(static_cast<uint32_t>(s.onCores.size()));
+        for (const SchedulerState::OnCore& c : s.onCores) {
+            w.put<int32_t>(c.core);
+            w.put<uint32_t>(index.at(c.process));
+            w.put<int64_t>(c.slot.budget);
+            w.put<int32_t>(c.slot.delayLeft);
+            w.put<uint8_t>(static_cast<uint8_t>(c.slot.afterDelay));
+        }
+        w.str(s.policy);
+        w.put<uint64_t>(s.placement);
+        w.put<uint32_t>(static_cast<uint32_t>(s.ready.size()));
+        for (const SchedulingPolicy::Queued& q : s.ready) {
+            w.put<uint32_t>(index.at(q.process));
+            w.put<int32_t>(q.queue);
+            w.put<int32_t>(q.level);
+        }
+        w.put<uint32_t>(static_cast<uint32_t>(s.sleeping.size()));
+        for (const auto& [p, wakeTick] : s.sleeping) {
+            w.put<uint32_t>(index.at(p));
+            w.put<uint64_t>(wakeTick);
+        }
+
+        w.flush();
+        uint64_t total = w.size();
+        out.seekp(FILE_SIZE_OFFSET);
+        out.write(reinterpret_cast<const char*>(&total), sizeof(total));
+    }
+}
+
+bool Checkpoint::save(const std::string& path) {
+    wait();
+    auto img = std::make_shared<Image>();
+    auto start = std::chrono::steady_clock::now();
+    Scheduler::call([&] { capture(*img); });
+    auto pause = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+    std::cout << "Checkpoint of " << img->processes.size() << " processes taken at tick " << img->sched.tick
+        << " (" << pause.count() << " us); writing " << path << " in the background.\n";
+
+    writer = std::thread([img, path, start] {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Error: Cannot write checkpoint '" << path << "'\n";
+            return;
+        }
+        Writer w(out);
+        writeImage(*img, out, w);
+        if (!out) {
+            std::cerr << "Error: Writing checkpoint '" << path << "' failed.\n";
+            return;
+        }
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        std::cout << "\nCheckpoint written to " << path << " (" << w.size() << " bytes, " << ms.count() << " ms)\n";
+    });
+    return true;
+}
+
+void Checkpoint::wait() {
+    if (writer.joinable()) writer.join();
+}
+
+bool Checkpoint::restore(const std::string& path) {
+    wait();
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Error: Cannot open checkpoint '" << path << "'\n";
+        return false;
+    }
+
+    struct Memory {
+        uint32_t size;
+        uint32_t pageCount;
+        const uint8_t* pages; // (u32 index, i32 frame, page bytes) records
+    };
+
+    std::vector<Process*> processes;
+    std::vector<Memory> memory;
+    SchedulerState sched;
+    MemoryState frames;
+    uint32_t pageSize = 0;
+    try {
+        Reader r(file.data, file.size);
+        if (std::memcmp(r.bytes(sizeof(MAGIC)), MAGIC, sizeof(MAGIC)) != 0) {
+            throw std::runtime_error("not a checkpoint file");
+        }
+        uint32_t version = r.get<uint32_t>();
+        if (version != VERSION) throw std::runtime_error("unsupported version " + std::to_string(version));
+        pageSize = r.get<uint32_t>();
+        uint64_t count = r.get<uint64_t>();
+        if (r.get<uint64_t>() != file.size) throw std::runtime_error("file is incomplete");
+
+        sched.tick = r.get<uint64_t>();
+        sched.nextProcessId = r.get<int32_t>();
+        sched.tickCounter = r.get<int32_t>();
+        sched.running = r.get<uint8_t>() != 0;
+        sched.pausedArrivals = r.get<uint64_t>();
+        sched.finishedCount = r.get<uint64_t>();
+        sched.totalWaiting = r.get<uint64_t>();
+        sched.totalTurnaround = r.get<uint64_t>();
+
+        frames.frameSize = pageSize;
+        frames.nextLoadSeq = r.get<uint64_t>();
+        frames.frames.resize(r.get<uint32_t>());
+        for (MemoryState::FrameInfo& f : frames.frames) {
+            f.loadSeq = r.get<uint64_t>();
+            f.lastUse = r.get<uint64_t>();
+            f.pinned = r.get<uint8_t>() != 0;
+        }
+        frames.freeFrames.resize(r.get<uint32_t>());
+        for (int32_t& f : frames.freeFrames) f = r.get<int32_t>();
+
+        processes.reserve(count);
+        memory.reserve(count);
+        std::shared_ptr<Arena> arena;
+        ProcessState st;
+        for (uint64_t i = 0; i < count; ++i) {
+            if (i % PROCESSES_PER_ARENA == 0) arena = std::make_shared<Arena>();
+            std::string name(r.str());
+            st.current_line = r.get<uint64_t>();
+            st.finished = r.get<uint8_t>() != 0;
+            st.manual = r.get<uint8_t>() != 0;
+            st.for_level = r.get<int8_t>();
+            st.for_body_pending = r.get<uint8_t>() != 0;
+            for (int& it : st.for_iter) it = r.get<int32_t>();
+            st.sched = SchedInfo{};
+            st.sched.pid = r.get<uint32_t>();
+            st.sched.priority = r.get<int32_t>();
+            st.sched.level = r.get<int32_t>();
+            st.sched.boost_epoch = r.get<uint64_t>();
+            st.sched.seq = r.get<uint64_t>();
+            st.sched.arrival_tick = r.get<uint64_t>();
+            st.sched.ready_since = r.get<uint64_t>();
+            st.sched.waiting_ticks = r.get<uint64_t>();
+            st.sched.last_core = r.get<int32_t>();
+
+            uint32_t instrCount = r.get<uint32_t>();
+            InstructionList ins{ ArenaAllocator<Instruction>(arena.get()) };
+            ins.reserve(instrCount);
+            ArenaAllocator<std::string> argAlloc(arena.get());
+            for (uint32_t k = 0; k < instrCount; ++k) {
+                Instruction& instr = ins.emplace_back();
+                instr.type = static_cast<Instruction::Type>(r.get<uint8_t>());
+                if (instr.type > Instruction::WRITE) throw std::runtime_error("bad instruction");
+                uint8_t argc = r.get<uint8_t>();
+                instr.args = ArgList(argAlloc);
+                instr.args.reserve(argc);
+                for (uint8_t a = 0; a < argc; ++a) instr.args.emplace_back(r.str());
+            }
+
+            uint32_t varCount = r.get<uint32_t>();
+            st.variables.clear();
+            st.variables.reserve(varCount);
+            for (uint32_t k = 0; k < varCount; ++k) {
+                std::string var(r.str());
+                st.variables.emplace_back(std::move(var), r.get<uint16_t>());
+            }
+
+            Process* p = Process::create(name, std::move(ins), arena);
+            processes.push_back(p);
+            p->loadState(st);
+            uint32_t logCount = r.get<uint32_t>();
+            for (uint32_t k = 0; k < logCount; ++k) p->addLog(r.str());
+            p->publishSnapshot(sched.tick);
+
+            Memory m;
+            m.size = r.get<uint32_t>();
+            m.pageCount = r.get<uint32_t>();
+            m.pages = r.bytes(static_cast<size_t>(m.pageCount) * (sizeof(uint32_t) + sizeof(int32_t) + pageSize));
+            memory.push_back(m);
+        }
+
+        uint32_t onCoreCount = r.get<uint32_t>();
+        for (uint32_t k = 0; k < onCoreCount; ++k) {
+            SchedulerState::OnCore c;
+            c.core = r.get<int32_t>();
+            c.process = processes.at(r.get<uint32_t>());
+            c.slot.budget = r.get<int64_t>();
+            c.slot.delayLeft = r.get<int32_t>();
+            c.slot.afterDelay = static_cast<YieldReason>(r.get<uint8_t>());
+            sched.onCores.push_back(c);
+        }
+        sched.policy = std::string(r.str());
+        sched.placement = r.get<uint64_t>();
+        uint32_t readyCount = r.get<uint32_t>();
+        for (uint32_t k = 0; k < readyCount; ++k) {
+            SchedulingPolicy::Queued q;
+            q.process = processes.at(r.get<uint32_t>());
+            q.queue = r.get<int32_t>();
+            q.level = r.get<int32_t>();
+            sched.ready.push_back(q);
+        }
+        uint32_t sleepCount = r.get<uint32_t>();
+        for (uint32_t k = 0; k < sleepCount; ++k) {
+            Process* p = processes.at(r.get<uint32_t>());
+            sched.sleeping.emplace_back(p, r.get<uint64_t>());
+        }
+    }
+    catch (const std::exception& e) {
+        for (Process* p : processes) Process::destroy(p);
+        std::cerr << "Error: Cannot restore '" << path << "': " << e.what() << "\n";
+        return false;
+    }
+
+    // nothing is running from here on until the scheduler restarts on the new state
+    Scheduler::shutdown();
+    ScreenManager::replaceProcesses(processes);
+    if (!MemoryManager::initialize()) { // the restored pages go into its backing store
+        std::cerr << "Error: Cannot restore '" << path << "': no backing store; run initialize\n";
+        return false;
+    }
+    bool sameFrames = MemoryManager::loadFrames(frames); // else every page starts out paged out
+    for (size_t i = 0; i < processes.size(); ++i) {
+        const Memory& m = memory[i];
+        if (m.size == 0) continue; // finished
+        AddressSpace& as = processes[i]->getMemory();
+        MemoryManager::attach(as, m.size);
+        const uint8_t* rec = m.pages;
+        for (uint32_t k = 0; k < m.pageCount; ++k) {
+            uint32_t page;
+            int32_t frame;
+            std::memcpy(&page, rec, sizeof(page));
+            std::memcpy(&frame, rec + sizeof(page), sizeof(frame));
+            rec += sizeof(page) + sizeof(frame);
+            MemoryManager::loadBytes(as, page * pageSize, rec, pageSize);
+            if (sameFrames && frame >= 0) MemoryManager::loadResident(as, page, frame);
+            rec += pageSize;
+        }
+    }
+    Scheduler::restore(sched);
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << "Restored " << processes.size() << " processes at tick " << sched.tick << " from " << path
+        << " (" << ms.count() << " ms)\n";
+    return true;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// Versioned binary snapshot of the whole emulator: every process (instructions, PC,
+// FOR counters, variables, logs and memory), the ready and sleep queues, and the
+// scheduler counters.
+//
+// save() takes its cut on the scheduler thread between two ticks, copying only the
+// state that can still change, and a background thread writes the file, so the
+// cores never wait for the disk. restore() maps the file and rebuilds the processes
+// and queues in one pass.
+class Checkpoint {
+public:
+    static constexpr uint32_t VERSION = 2; // 2: SchedInfo has the pid
+    static constexpr const char* DEFAULT_PATH = "csopesy.ckpt";
+
+    static bool save(const std::string& path);
+    static bool restore(const std::string& path); // replaces every process; needs a loaded config
+    static void wait(); // joins a write still in progress
+
+private:
+    static std::thread writer;
+};
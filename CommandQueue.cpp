@@ -0,0 +1,23 @@
+#include "CommandQueue.h"
+
+void CommandQueue::post(Command cmd) {
+    std::lock_guard<std::mutex> lock(mtx);
+    pending.push_back(std::move(cmd));
+}
+
+size_t CommandQueue::drain() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (pending.empty()) return 0;
+        batch.swap(pending);
+    }
+    for (auto& cmd : batch) cmd();
+    size_t count = batch.size();
+    batch.clear();
+    return count;
+}
+
+bool CommandQueue::empty() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return pending.empty();
+}
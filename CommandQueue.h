@@ -0,0 +1,21 @@
+#pragma once
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Multi-producer queue of work for the scheduler thread. The shell posts and returns
+// at once; the scheduler runs whatever is pending at the start of its next tick, so
+// scheduler state is only ever changed on the scheduler thread.
+class CommandQueue {
+public:
+    using Command = std::function<void()>;
+
+    void post(Command cmd);
+    size_t drain(); // runs every pending command on the calling thread
+    bool empty() const;
+
+private:
+    mutable std::mutex mtx;
+    std::vector<Command> pending;
+    std::vector<Command> batch; // drain() swaps pending into this to run it unlocked
+};
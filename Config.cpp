@@ -5,6 +5,7 @@
 #include <vector>
 #include <climits>
 #include <cctype>
+#include "Topology.h"
 
 // statics
 int Config::num_cpu = 0;
@@ -14,6 +15,23 @@ int Config::batch_process_freq = 0;
 int Config::min_ins = 0;
 int Config::max_ins = 0;
 int Config::delay_per_exec = 0;
+std::string Config::time_mode = "real";
+bool Config::has_random_seed = false;
+unsigned int Config::random_seed = 0;
+int Config::gen_queue_depth = 64;
+int Config::max_live_processes = 0;
+int Config::aging_interval = 10;
+int Config::mlfq_levels = 3;
+int Config::mlfq_boost_interval = 100;
+bool Config::process_logging = true;
+int Config::max_overall_mem = 16384;
+int Config::mem_per_frame = 256;
+int Config::min_mem_per_proc = 4096;
+int Config::max_mem_per_proc = 4096;
+std::string Config::page_replacement = "fifo";
+std::string Config::backing_store = "csopesy-backing-store.bin";
+std::string Config::cpu_affinity = "off";
+std::vector<int> Config::cpu_list;
 bool Config::loaded = false;
 
 bool Config::load(const std::string& filename) {
@@ -23,6 +41,25 @@ bool Config::load(const std::string& filename) {
         return false;
     }
 
+    // optional keys fall back to their defaults on every load
+    time_mode = "real";
+    has_random_seed = false;
+    random_seed = 0;
+    gen_queue_depth = 64;
+    max_live_processes = 0;
+    aging_interval = 10;
+    mlfq_levels = 3;
+    mlfq_boost_interval = 100;
+    process_logging = true;
+    max_overall_mem = 16384;
+    mem_per_frame = 256;
+    min_mem_per_proc = 4096;
+    max_mem_per_proc = 4096;
+    page_replacement = "fifo";
+    backing_store = "csopesy-backing-store.bin";
+    cpu_affinity = "off";
+    cpu_list.clear();
+
     std::string line;
     int line_num = 1;
     while (std::getline(file, line)) {
@@ -42,7 +79,7 @@ bool Config::load(const std::string& filename) {
             if (tokens.size() != 2) goto invalid_line;
             try {
                 int val = std::stoi(tokens[1]);
-                if (val < 1 || val > 128) goto invalid_value;
+                if (val < 1 || val > MAX_NUM_CPU) goto invalid_value;
                 num_cpu = val;
             }
             catch (...) { goto invalid_value; }
@@ -56,6 +93,18 @@ bool Config::load(const std::string& filename) {
             else if (val == "fcfs" || val == "\"fcfs\"") {
                 scheduler = "fcfs";
             }
+            else if (val == "sjf" || val == "\"sjf\"") {
+                scheduler = "sjf";
+            }
+            else if (val == "srtf" || val == "\"srtf\"") {
+                scheduler = "srtf";
+            }
+            else if (val == "priority" || val == "\"priority\"") {
+                scheduler = "priority";
+            }
+            else if (val == "mlfq" || val == "\"mlfq\"") {
+                scheduler = "mlfq";
+            }
             else {
                 goto invalid_value;
             }
@@ -105,6 +154,157 @@ bool Config::load(const std::string& filename) {
             }
             catch (...) { goto invalid_value; }
         }
+        else if (tokens[0] == "time-mode") {
+            if (tokens.size() != 2) goto invalid_line;
+            std::string val = tokens[1];
+            if (val == "real" || val == "\"real\"") {
+                time_mode = "real";
+            }
+            else if (val == "virtual" || val == "\"virtual\"") {
+                time_mode = "virtual";
+            }
+            else {
+                goto invalid_value;
+            }
+        }
+        else if (tokens[0] == "random-seed") {
+            if (tokens.size() != 2) goto invalid_line;
+            try {
+                long long val = std::stoll(tokens[1]);
+                if (val < 0 || val > UINT32_MAX) goto invalid_value;
+                random_seed = static_cast<unsigned int>(val);
+                has_random_seed = true;
+            }
+            catch (...) { goto invalid_value; }
+        }
+        else if (tokens[0] == "gen-queue-depth") {
+            if (tokens.size() != 2) goto invalid_line;
+            try {
+                int val = std::stoi(tokens[1]);
+                if (val < 1 || val > 65536) goto invalid_value;
+                gen_queue_depth = val;
+            }
+            catch (...) { goto invalid_value; }
+        }
+        else if (tokens[0] == "max-live-processes") {
+            if (tokens.size() != 2) goto invalid_line;
+            try {
+                int val = std::stoi(tokens[1]);
+                if (val < 0) goto invalid_value;
+                max_live_processes = val;
+            }
+            catch (...) { goto invalid_value; }
+        }
+        else if (tokens[0] == "aging-interval") {
+            if (tokens.size() != 2) goto invalid_line;
+            try {
+                int val = std::stoi(tokens[1]);
+                if (val < 1) goto invalid_value;
+                aging_interval = val;
+            }
+            catch (...) { goto invalid_value; }
+        }
+        else if (tokens[0] == "mlfq-levels") {
+            if (tokens.size() != 2) goto invalid_line;
+            try {
+                int val = std::stoi(tokens[1]);
+                if (val < 1 || val > 8) goto invalid_value;
+                mlfq_levels = val;
+            }
+            catch (...) { goto invalid_value; }
+        }
+        else if (tokens[0] == "mlfq-boost-interval") {
+            if (tokens.size() != 2) goto invalid_line;
+            try {
+                int val = std::stoi(tokens[1]);
+                if (val < 1) goto invalid_value;
+                mlfq_boost_interval = val;
+            }
+            catch (...) { goto invalid_value; }
+        }
+        else if (tokens[0] == "process-logging") {
+            if (tokens.size() != 2) goto invalid_line;
+            std::string val = tokens[1];
+            if (val == "on" || val == "\"on\"") {
+                process_logging = true;
+            }
+            else if (val == "off" || val == "\"off\"") {
+                process_logging = false;
+            }
+            else {
+                goto invalid_value;
+            }
+        }
+        else if (tokens[0] == "max-overall-mem") {
+            if (tokens.size() != 2) goto invalid_line;
+            try {
+                int val = std::stoi(tokens[1]);
+                if (val < 64 || val > (1 << 30) || (val & (val - 1)) != 0) goto invalid_value;
+                max_overall_mem = val;
+            }
+            catch (...) { goto invalid_value; }
+        }
+        else if (tokens[0] == "mem-per-frame") {
+            if (tokens.size() != 2) goto invalid_line;
+            try {
+                int val = std::stoi(tokens[1]);
+                if (val < 64 || val > 65536 || (val & (val - 1)) != 0) goto invalid_value;
+                mem_per_frame = val;
+            }
+            catch (...) { goto invalid_value; }
+        }
+        else if (tokens[0] == "min-mem-per-proc") {
+            if (tokens.size() != 2) goto invalid_line;
+            try {
+                int val = std::stoi(tokens[1]);
+                if (val < 64 || val > 65536 || (val & (val - 1)) != 0) goto invalid_value;
+                min_mem_per_proc = val;
+            }
+            catch (...) { goto invalid_value; }
+        }
+        else if (tokens[0] == "max-mem-per-proc") {
+            if (tokens.size() != 2) goto invalid_line;
+            try {
+                int val = std::stoi(tokens[1]);
+                if (val < 64 || val > 65536 || (val & (val - 1)) != 0) goto invalid_value;
+                max_mem_per_proc = val;
+            }
+            catch (...) { goto invalid_value; }
+        }
+        else if (tokens[0] == "page-replacement") {
+            if (tokens.size() != 2) goto invalid_line;
+            std::string val = tokens[1];
+            if (val == "fifo" || val == "\"fifo\"") {
+                page_replacement = "fifo";
+            }
+            else if (val == "lru" || val == "\"lru\"") {
+                page_replacement = "lru";
+            }
+            else {
+                goto invalid_value;
+            }
+        }
+        else if (tokens[0] == "backing-store") {
+            if (tokens.size() != 2) goto invalid_line;
+            std::string val = tokens[1];
+            if (val.size() >= 2 && val.front() == '"' && val.back() == '"') val = val.substr(1, val.size() - 2);
+            if (val.empty()) goto invalid_value;
+            backing_store = val;
+        }
+        else if (tokens[0] == "cpu-affinity") {
+            if (tokens.size() != 2) goto invalid_line;
+            std::string val = tokens[1];
+            if (val.size() >= 2 && val.front() == '"' && val.back() == '"') val = val.substr(1, val.size() - 2);
+            if (val == "off" || val == "compact" || val == "scatter") {
+                cpu_affinity = val;
+            }
+            else if (Topology::parseCpuList(val, cpu_list)) {
+                cpu_affinity = "list";
+            }
+            else {
+                goto invalid_value;
+            }
+        }
         else {
             std::cerr << "Unknown parameter at line " << line_num << ": " << tokens[0] << "\n";
             file.close();
@@ -127,6 +327,16 @@ bool Config::load(const std::string& filename) {
         return false;
     }
 
+    if (min_mem_per_proc > max_mem_per_proc) {
+        std::cerr << "min-mem-per-proc cannot be greater than max-mem-per-proc.\n";
+        return false;
+    }
+
+    if (mem_per_frame > max_overall_mem) {
+        std::cerr << "mem-per-frame cannot be greater than max-overall-mem.\n";
+        return false;
+    }
+
     loaded = true;
     std::cout << "Config loaded successfully.\n";
     return true;
@@ -145,11 +355,30 @@ invalid_value:
 // Getters  
 std::string Config::getScheduler() { return scheduler; }
 int Config::getNumCpu() { return num_cpu; }
+void Config::setNumCpu(int n) { num_cpu = n; }
 int Config::getQuantumCycles() { return quantum_cycles; }
 int Config::getBatchProcessFreq() { return batch_process_freq; }
 int Config::getMinIns() { return min_ins; }
 int Config::getMaxIns() { return max_ins; }
 int Config::getDelayPerExec() { return delay_per_exec; }
+std::string Config::getTimeMode() { return time_mode; }
+bool Config::isVirtualTime() { return time_mode == "virtual"; }
+bool Config::hasRandomSeed() { return has_random_seed; }
+unsigned int Config::getRandomSeed() { return random_seed; }
+int Config::getGenQueueDepth() { return gen_queue_depth; }
+int Config::getMaxLiveProcesses() { return max_live_processes; }
+int Config::getAgingInterval() { return aging_interval; }
+int Config::getMlfqLevels() { return mlfq_levels; }
+int Config::getMlfqBoostInterval() { return mlfq_boost_interval; }
+bool Config::isProcessLogging() { return process_logging; }
+int Config::getMaxOverallMem() { return max_overall_mem; }
+int Config::getMemPerFrame() { return mem_per_frame; }
+int Config::getMinMemPerProc() { return min_mem_per_proc; }
+int Config::getMaxMemPerProc() { return max_mem_per_proc; }
+std::string Config::getPageReplacement() { return page_replacement; }
+std::string Config::getBackingStorePath() { return backing_store; }
+std::string Config::getCpuAffinity() { return cpu_affinity; }
+const std::vector<int>& Config::getCpuList() { return cpu_list; }
 
 void Config::printSummary() {
     if (!loaded) return;
@@ -161,6 +390,27 @@ void Config::printSummary() {
     std::cout << "   min-ins: " << min_ins << "\n";
     std::cout << "   max-ins: " << max_ins << "\n";
     std::cout << "   delay-per-exec: " << delay_per_exec << "\n";
+    std::cout << "   time-mode: " << time_mode << "\n";
+    if (has_random_seed) std::cout << "   random-seed: " << random_seed << "\n";
+    std::cout << "   gen-queue-depth: " << gen_queue_depth << "\n";
+    std::cout << "   max-live-processes: " << max_live_processes << "\n";
+    std::cout << "   max-overall-mem: " << max_overall_mem << "\n";
+    std::cout << "   mem-per-frame: " << mem_per_frame << "\n";
+    std::cout << "   min-mem-per-proc: " << min_mem_per_proc << "\n";
+    std::cout << "   max-mem-per-proc: " << max_mem_per_proc << "\n";
+    std::cout << "   page-replacement: " << page_replacement << "\n";
+    std::cout << "   backing-store: " << backing_store << "\n";
+    std::cout << "   process-logging: " << (process_logging ? "on" : "off") << "\n";
+    std::cout << "   cpu-affinity: " << cpu_affinity;
+    if (cpu_affinity == "list") {
+        for (size_t i = 0; i < cpu_list.size(); ++i) std::cout << (i ? "," : " ") << cpu_list[i];
+    }
+    std::cout << "\n";
+    if (scheduler == "priority") std::cout << "   aging-interval: " << aging_interval << "\n";
+    if (scheduler == "mlfq") {
+        std::cout << "   mlfq-levels: " << mlfq_levels << "\n";
+        std::cout << "   mlfq-boost-interval: " << mlfq_boost_interval << "\n";
+    }
     std::cout << "====================================\n";
 
 }
\ No newline at end of file
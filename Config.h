@@ -1,17 +1,39 @@
 #pragma once
 #include <string>
+#include <vector>
 
 class Config {
 public:
+    static constexpr int MAX_NUM_CPU = 128;
+
     static bool load(const std::string& filename);
 
     static int getNumCpu();
+    static void setNumCpu(int n); // the cores command resized the running scheduler
     static std::string getScheduler();
     static int getQuantumCycles();
     static int getBatchProcessFreq();
     static int getMinIns();
     static int getMaxIns();
     static int getDelayPerExec();
+    static std::string getTimeMode();
+    static bool isVirtualTime();
+    static bool hasRandomSeed();
+    static unsigned int getRandomSeed();
+    static int getGenQueueDepth();
+    static int getMaxLiveProcesses();
+    static int getAgingInterval();
+    static int getMlfqLevels();
+    static int getMlfqBoostInterval();
+    static bool isProcessLogging();
+    static int getMaxOverallMem();
+    static int getMemPerFrame();
+    static int getMinMemPerProc();
+    static int getMaxMemPerProc();
+    static std::string getPageReplacement();
+    static std::string getBackingStorePath();
+    static std::string getCpuAffinity(); // off, compact, scatter or list
+    static const std::vector<int>& getCpuList();
     static void printSummary();
 
 private:
@@ -22,5 +44,22 @@ private:
     static int min_ins;
     static int max_ins;
     static int delay_per_exec;
+    static std::string time_mode;   // optional, "real" (default) or "virtual"
+    static bool has_random_seed;    // optional random-seed makes generation reproducible
+    static unsigned int random_seed;
+    static int gen_queue_depth;     // optional, processes built ahead of admission
+    static int max_live_processes;  // optional, 0 = no cap on unfinished processes
+    static int aging_interval;      // optional, priority: ticks of waiting per level gained
+    static int mlfq_levels;         // optional, mlfq: number of queues
+    static int mlfq_boost_interval; // optional, mlfq: ticks between moving everything to the top
+    static bool process_logging;    // optional, "off" stops generated processes from keeping logs
+    static int max_overall_mem;     // optional, bytes of emulated physical memory
+    static int mem_per_frame;       // optional, frame and page size in bytes
+    static int min_mem_per_proc;    // optional, address space size range of generated processes
+    static int max_mem_per_proc;
+    static std::string page_replacement; // optional, "fifo" (default) or "lru"
+    static std::string backing_store;    // optional, file evicted pages are mapped into
+    static std::string cpu_affinity;     // optional, pins core threads to host CPUs: off, compact, scatter or a CPU list
+    static std::vector<int> cpu_list;
     static bool loaded;
 };
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "CpuCore.h"
+#include <exception>
+#include "PerfCounters.h"
+#include "Topology.h"
+
+// ---------- TickSync ----------
+
+void TickSync::begin(int participants) {
+    pending.store(participants, std::memory_order_release);
+}
+
+void TickSync::waitAll() {
+    uint32_t seen = done.current();
+    while (pending.load(std::memory_order_acquire) != 0) {
+        seen = done.wait(seen, stats);
+    }
+}
+
+void TickSync::arrive() {
+    if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) done.ring();
+}
+
+// ---------- CpuCore ----------
+
+CpuCore::CpuCore(int id, TickSync& sync)
+    : id(id), sync(sync), stopping(false), armedTick(0), process(nullptr),
+    lastReason(YieldReason::NONE), waitTicks(0), cycle(&CpuCore::runCycle<false>), delayLeft(0),
+    afterDelay(YieldReason::CYCLE), switched(false), trace(nullptr), startTick(0),
+    hostCpu(-1), pinned(false), settled(false), busyTicks(0), instructions(0) {
+}
+
+CpuCore::~CpuCore() {
+    stop();
+}
+
+void CpuCore::start(const ExecProfile& p) {
+    profile = p;
+    cycle = profile.hasDelay() ? &CpuCore::runCycle<true> : &CpuCore::runCycle<false>;
+    stopping = false;
+    // sampled here, not on the new thread, so an arm() right after start() is not lost
+    worker = std::thread(&CpuCore::threadLoop, this, doorbell.current(), armedTick.load(std::memory_order_acquire));
+    while (hostCpu >= 0 && !settled.load(std::memory_order_acquire)) std::this_thread::yield();
+}
+
+void CpuCore::stop() {
+    if (!worker.joinable()) return;
+    stopping = true;
+    doorbell.ring();
+    worker.join();
+}
+
+void CpuCore::assign(Process* p, int64_t quantum) {
+    process = p;
+    delayLeft = 0;
+    lastReason = YieldReason::NONE;
+    waitTicks = 0;
+    switched = true;
+    p->getTask(profile.logging).setBudget(quantum);
+}
+
+CpuCore::Slot CpuCore::saveSlot() const {
+    return { process->getTask(profile.logging).getBudget(), delayLeft, afterDelay };
+}
+
+void CpuCore::resume(Process* p, const Slot& slot) {
+    assign(p, slot.budget);
+    delayLeft = slot.delayLeft;
+    afterDelay = slot.afterDelay;
+}
+
+Process* CpuCore::release() {
+    Process* p = process;
+    process = nullptr;
+    return p;
+}
+
+void CpuCore::arm(uint64_t tick) {
+    armedTick.store(tick, std::memory_order_release);
+    doorbell.ring();
+}
+
+void CpuCore::threadLoop(uint32_t seen, uint64_t lastTick) {
+    LogRecordPool::setCurrentCore(id);
+    PerfCounters::setCurrentCore(id);
+    if (hostCpu >= 0) {
+        pinned.store(Topology::pinCurrentThread(hostCpu), std::memory_order_relaxed);
+        settled.store(true, std::memory_order_release);
+    }
+    while (true) {
+        seen = doorbell.wait(seen, idleStats);
+        if (stopping) break;
+        uint64_t tick = armedTick.load(std::memory_order_acquire);
+        if (tick == lastTick) continue;
+        lastTick = tick;
+        (this->*cycle)();
+        if (trace) traceOutcome(tick);
+        sync.arrive();
+    }
+}
+
+template <bool Delay>
+void CpuCore::runCycle() {
+    busyTicks.fetch_add(1, std::memory_order_relaxed);
+
+    // delay-per-exec: the core stays busy for that many ticks after each instruction
+    if constexpr (Delay) {
+        if (delayLeft > 0) {
+            delayLeft--;
+            lastReason = delayLeft == 0 ? afterDelay : YieldReason::CYCLE;
+            return;
+        }
+    }
+
+    ProcessTask& task = process->getTask();
+    uint64_t switchStart = switched ? PerfCounters::start() : 0;
+    try {
+        lastReason = task.resume();
+    }
+    catch (const std::exception& e) {
+        process->addLog(std::string("Error: ") + e.what());
+        process->setFinished(true);
+        lastReason = YieldReason::FINISHED;
+    }
+    if (switched) { // the first resume of a newly assigned process, cold frame and all
+        PerfCounters::recordSwitch(switchStart);
+        switched = false;
+    }
+    if (lastReason != YieldReason::WAIT) instructions.fetch_add(1, std::memory_order_relaxed); // a fault retires nothing
+    process->publishSnapshot(armedTick.load(std::memory_order_relaxed));
+
+    if (lastReason == YieldReason::SLEEP || lastReason == YieldReason::WAIT) {
+        waitTicks = task.getWaitTicks();
+    }
+    else if constexpr (Delay) {
+        // the last instruction of a quantum is delayed too; the core gives the process
+        // back once the delay is over
+        if (lastReason == YieldReason::CYCLE || lastReason == YieldReason::QUANTUM) {
+            afterDelay = lastReason;
+            delayLeft = profile.delayPerExec;
+            lastReason = YieldReason::CYCLE;
+        }
+    }
+}
+
+void CpuCore::traceOutcome(uint64_t tick) {
+    TraceEvent type;
+    switch (lastReason) {
+    case YieldReason::QUANTUM: type = TraceEvent::PREEMPT; break;
+    case YieldReason::SLEEP: type = TraceEvent::SLEEP; break;
+    case YieldReason::FINISHED: type = TraceEvent::FINISH; break;
+    default: return; // still running, or waiting on a page with the core
+    }
+    int64_t arg = type == TraceEvent::SLEEP ? static_cast<int64_t>(waitTicks) : 0;
+    trace->add(type, tick, id, process->getSchedInfo().pid, arg);
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "Process.h"
+#include "EventCount.h"
+#include "InstructionExecutor.h"
+#include "Trace.h"
+
+// Lockstep clock between the scheduler thread and the cores. The scheduler rings
+// only the cores that hold a process and waits until every one of them has executed
+// its cycle, so the outcome of a run does not depend on thread timing.
+class TickSync {
+public:
+    void begin(int participants); // scheduler: before ringing the armed cores
+    void waitAll();               // scheduler: spin-then-park until all arrived
+    void arrive();                // core: finished its cycle
+
+    const IdleStats& getStats() const { return stats; }
+    void resetStats() { stats.reset(); }
+
+private:
+    std::atomic<int> pending{ 0 };
+    EventCount done;
+    IdleStats stats;
+};
+
+// One emulated CPU. The scheduler thread assigns processes between ticks; the core
+// thread resumes the assigned process task once per tick.
+class CpuCore {
+public:
+    CpuCore(int id, TickSync& sync);
+    ~CpuCore();
+    CpuCore(const CpuCore&) = delete;
+    CpuCore& operator=(const CpuCore&) = delete;
+
+    void start(const ExecProfile& profile); // picks the cycle instantiation for the run
+    void stop();
+
+    int getId() const { return id; }
+    bool isIdle() const { return process == nullptr; }
+    Process* getProcess() const { return process; }
+
+    // Scheduler thread only, between ticks.
+    void assign(Process* p, int64_t quantum);
+    Process* release();
+    void arm(uint64_t tick); // this core takes part in the given tick; wakes it
+    YieldReason getLastReason() const { return lastReason; }
+    void setTrace(TraceBuffer* buffer) { trace = buffer; } // the core records how each cycle ended
+    TraceBuffer* getTrace() const { return trace; }
+    uint64_t getWaitTicks() const { return waitTicks; }
+
+    // Checkpoint support: what is left of the assigned process's quantum and delay.
+    struct Slot {
+        int64_t budget;
+        int delayLeft;
+        YieldReason afterDelay;
+    };
+    Slot saveSlot() const;
+    void resume(Process* p, const Slot& slot); // assign, carrying on from a saved slot
+
+    void setHostCpu(int cpu) { hostCpu = cpu; } // before start(), which returns once the thread has pinned itself; -1 = anywhere
+    int getHostCpu() const { return hostCpu; }
+    bool isPinned() const { return pinned.load(std::memory_order_acquire); }
+    void setStartTick(uint64_t tick) { startTick = tick; } // before start()
+    uint64_t getStartTick() const { return startTick; }
+    uint64_t getBusyTicks() const { return busyTicks.load(std::memory_order_relaxed); }
+    uint64_t getInstructionsExecuted() const { return instructions.load(std::memory_order_relaxed); }
+    const IdleStats& getIdleStats() const { return idleStats; }
+    void resetIdleStats() { idleStats.reset(); }
+
+private:
+    int id;
+    TickSync& sync;
+    std::thread worker;
+    std::atomic<bool> stopping;
+    std::atomic<uint64_t> armedTick;
+    EventCount doorbell; // rung by arm() and stop(); idle cores stay parked on it
+    IdleStats idleStats;
+
+    Process* process;
+    YieldReason lastReason;
+    uint64_t waitTicks;
+    ExecProfile profile;
+    void (CpuCore::*cycle)(); // runCycle<hasDelay>
+    int delayLeft;
+    YieldReason afterDelay; // reported when the delay runs out
+    bool switched;          // assigned since its last cycle
+    TraceBuffer* trace;
+    uint64_t startTick; // busyTicks counts from here
+    int hostCpu;
+    std::atomic<bool> pinned;
+    std::atomic<bool> settled; // the thread has tried to pin itself
+
+    std::atomic<uint64_t> busyTicks;
+    std::atomic<uint64_t> instructions;
+
+    void threadLoop(uint32_t seen, uint64_t lastTick);
+    template <bool Delay> void runCycle();
+    void traceOutcome(uint64_t tick);
+};
@@ -0,0 +1,67 @@
+#include "EventCount.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CPU_RELAX() _mm_pause()
+#else
+#define CPU_RELAX() std::this_thread::yield()
+#endif
+
+int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void IdleStats::reset() {
+    spin_hits = 0;
+    parks = 0;
+    wakeups = 0;
+    wake_latency_ns = 0;
+    wake_latency_max_ns = 0;
+}
+
+static void bump(std::atomic<uint64_t>& counter, uint64_t by = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+uint32_t EventCount::wait(uint32_t seen, IdleStats& stats) {
+    uint32_t now = seq.load(std::memory_order_acquire);
+    for (int i = 0; now == seen && i < spinLimit; ++i) {
+        CPU_RELAX();
+        now = seq.load(std::memory_order_acquire);
+    }
+
+    if (now == seen) {
+        bump(stats.parks);
+        parked.store(true, std::memory_order_seq_cst);
+        // the store above and ring()'s seq bump are both seq_cst, so either we see the
+        // new value here or ring() sees parked and notifies
+        while ((now = seq.load(std::memory_order_seq_cst)) == seen) {
+            seq.wait(seen, std::memory_order_seq_cst);
+        }
+        parked.store(false, std::memory_order_relaxed);
+        spinLimit = std::max(MIN_SPIN, spinLimit / 2);
+    }
+    else {
+        bump(stats.spin_hits);
+        spinLimit = std::min(MAX_SPIN, spinLimit * 2);
+    }
+
+    int64_t latency = steadyNowNs() - ringedAtNs.load(std::memory_order_relaxed);
+    if (latency > 0) {
+        bump(stats.wake_latency_ns, static_cast<uint64_t>(latency));
+        if (static_cast<uint64_t>(latency) > stats.wake_latency_max_ns.load(std::memory_order_relaxed)) {
+            stats.wake_latency_max_ns.store(static_cast<uint64_t>(latency), std::memory_order_relaxed);
+        }
+    }
+    bump(stats.wakeups);
+    return now;
+}
+
+void EventCount::ring() {
+    ringedAtNs.store(steadyNowNs(), std::memory_order_relaxed);
+    seq.fetch_add(1, std::memory_order_seq_cst);
+    if (parked.load(std::memory_order_seq_cst)) seq.notify_one();
+}
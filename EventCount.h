@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Counters for one waiter. Written by the waiting thread, read by idle-stats.
+struct IdleStats {
+    std::atomic<uint64_t> spin_hits{ 0 };        // woken while still spinning
+    std::atomic<uint64_t> parks{ 0 };            // had to park in the kernel
+    std::atomic<uint64_t> wakeups{ 0 };
+    std::atomic<uint64_t> wake_latency_ns{ 0 };  // ring -> waiter running, summed
+    std::atomic<uint64_t> wake_latency_max_ns{ 0 };
+
+    void reset();
+};
+
+// Single-waiter eventcount. The waiter spins for an adaptive number of rounds and then
+// parks on the sequence word (std::atomic::wait, a futex on Linux and WaitOnAddress on
+// Windows). ring() only makes the wake-up syscall when the waiter actually parked.
+class EventCount {
+public:
+    uint32_t current() const { return seq.load(std::memory_order_acquire); }
+
+    // Waiter: returns once the sequence differs from seen.
+    uint32_t wait(uint32_t seen, IdleStats& stats);
+
+    // Any thread: publish a new event and wake the waiter if needed.
+    void ring();
+
+private:
+    static constexpr int MIN_SPIN = 16;
+    static constexpr int MAX_SPIN = 1 << 14;
+
+    std::atomic<uint32_t> seq{ 0 };
+    std::atomic<bool> parked{ false };
+    std::atomic<int64_t> ringedAtNs{ 0 };
+    int spinLimit = 1024; // waiter-owned; grows on spin hits, shrinks on parks
+};
+
+int64_t steadyNowNs();
@@ -0,0 +1,10 @@
+#include "InstructionExecutor.h"
+#include "Config.h"
+
+ExecProfile ExecProfile::fromConfig() {
+    ExecProfile profile;
+    profile.delayPerExec = Config::getDelayPerExec();
+    profile.logging = Config::isProcessLogging();
+    profile.virtualTime = Config::isVirtualTime();
+    return profile;
+}
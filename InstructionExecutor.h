@@ -1 +1,14 @@
 #pragma once
+
+// Settings the execution hot path is compiled against. They cannot change while the
+// scheduler runs, so the cores, the process tasks and the scheduler loop each pick a
+// matching instantiation once and carry no configuration checks per instruction.
+struct ExecProfile {
+    int delayPerExec = 0;
+    bool logging = true; // generated processes keep their log lines
+    bool virtualTime = false;
+
+    bool hasDelay() const { return delayPerExec > 0; }
+
+    static ExecProfile fromConfig();
+};
@@ -0,0 +1,351 @@
+#include "MemoryManager.h"
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include "Config.h"
+#include "Scheduler.h"
+
+std::vector<uint8_t> MemoryManager::physical;
+std::vector<MemoryManager::Frame> MemoryManager::frames;
+std::vector<int32_t> MemoryManager::freeFrames;
+uint32_t MemoryManager::frameSize = 256;
+int MemoryManager::frameShift = 8;
+bool MemoryManager::lru = false;
+uint64_t MemoryManager::loadSeq = 0;
+uint64_t MemoryManager::tick = 0;
+uint64_t MemoryManager::startTick = 0;
+BackingStore MemoryManager::store;
+
+std::mutex MemoryManager::registryMutex;
+std::vector<AddressSpace*> MemoryManager::spaces;
+
+std::atomic<uint64_t> MemoryManager::faults{ 0 };
+std::atomic<uint64_t> MemoryManager::pageIns{ 0 };
+std::atomic<uint64_t> MemoryManager::pageOuts{ 0 };
+std::atomic<uint64_t> MemoryManager::evictions{ 0 };
+std::atomic<uint64_t> MemoryManager::usedFrames{ 0 };
+std::atomic<uint64_t> MemoryManager::committedBytes{ 0 };
+std::atomic<uint64_t> MemoryManager::storeSlots{ 0 };
+std::atomic<uint64_t> MemoryManager::physicalBytes{ 0 };
+std::atomic<uint64_t> MemoryManager::frameBytes{ 0 };
+
+bool MemoryManager::initialize() {
+    uint32_t newFrameSize = static_cast<uint32_t>(Config::getMemPerFrame());
+    bool keepStore = store.isOpen() && newFrameSize == frameSize &&
+        store.getPath() == Config::getBackingStorePath();
+
+    frameSize = newFrameSize;
+    frameShift = std::countr_zero(frameSize);
+    size_t count = static_cast<size_t>(Config::getMaxOverallMem()) / frameSize;
+    physical.assign(count * frameSize, 0);
+    frames.assign(count, Frame{});
+    freeFrames.clear();
+    for (size_t f = count; f-- > 0; ) freeFrames.push_back(static_cast<int32_t>(f)); // frame 0 first
+    lru = Config::getPageReplacement() == "lru";
+    loadSeq = 0;
+    startTick = tick;
+
+    if (!keepStore) {
+        store.open(Config::getBackingStorePath(), frameSize);
+        // saved pages have the old frame size; the address spaces start over empty
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (AddressSpace* as : spaces) as->pages.assign(pagesFor(as->size), PageEntry{});
+    }
+
+    faults = 0;
+    pageIns = 0;
+    pageOuts = 0;
+    evictions = 0;
+    usedFrames = 0;
+    storeSlots = store.getSlotsInUse();
+    physicalBytes = physical.size();
+    frameBytes = frameSize;
+    return store.isOpen(); // open() said why not
+}
+
+void MemoryManager::shutdown() {
+    // cores are stopped; every resident page goes to the store
+    for (size_t f = 0; f < frames.size(); ++f) {
+        if (frames[f].owner) evict(static_cast<int32_t>(f));
+    }
+    frames.clear();
+    freeFrames.clear();
+    physical.clear();
+    usedFrames = 0;
+    physicalBytes = 0;
+}
+
+void MemoryManager::attach(AddressSpace& as, uint32_t bytes) {
+    as.size = bytes;
+    as.pages.assign(pagesFor(bytes), PageEntry{});
+    committedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(registryMutex);
+    spaces.push_back(&as);
+}
+
+void MemoryManager::release(AddressSpace& as) {
+    for (PageEntry& e : as.pages) {
+        if (e.frame >= 0) {
+            frames[e.frame] = Frame{};
+            freeFrames.push_back(e.frame);
+            usedFrames.fetch_sub(1, std::memory_order_relaxed);
+        }
+        store.freeSlot(e.slot);
+        e = PageEntry{};
+    }
+    storeSlots = store.getSlotsInUse();
+    committedBytes.fetch_sub(as.size, std::memory_order_relaxed);
+    as.size = 0; // releasing twice is harmless
+    as.pages.clear();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto it = std::find(spaces.begin(), spaces.end(), &as);
+    if (it != spaces.end()) {
+        *it = spaces.back();
+        spaces.pop_back();
+    }
+}
+
+uint8_t* MemoryManager::translate(AddressSpace& as, uint32_t addr, bool write) {
+    PageEntry& e = as.pages[addr >> frameShift];
+    if (e.frame < 0) {
+        as.faultPage = addr >> frameShift;
+        return nullptr;
+    }
+    Frame& f = frames[e.frame];
+    f.lastUse = tick;
+    f.pinned = false;
+    if (write) e.dirty = true;
+    return &physical[(static_cast<size_t>(e.frame) << frameShift) + (addr & (frameSize - 1))];
+}
+
+static void checkAccess(const AddressSpace& as, uint32_t addr) {
+    if (static_cast<uint64_t>(addr) + 2 > as.size) {
+        char msg[64];
+        std::snprintf(msg, sizeof(msg), "Memory access violation at 0x%X", addr);
+        throw std::out_of_range(msg);
+    }
+}
+
+// values are uint16 little-endian; the two bytes may sit on different pages
+bool MemoryManager::tryRead(AddressSpace& as, uint32_t addr, uint16_t& value) {
+    checkAccess(as, addr);
+    uint8_t* lo = translate(as, addr, false);
+    if (!lo) return false;
+    uint8_t* hi = translate(as, addr + 1, false);
+    if (!hi) return false;
+    value = static_cast<uint16_t>(*lo | (*hi << 8));
+    return true;
+}
+
+bool MemoryManager::tryWrite(AddressSpace& as, uint32_t addr, uint16_t value) {
+    checkAccess(as, addr);
+    // both pages must be resident before either byte changes
+    if (!translate(as, addr, false) || !translate(as, addr + 1, false)) return false;
+    *translate(as, addr, true) = static_cast<uint8_t>(value & 0xFF);
+    *translate(as, addr + 1, true) = static_cast<uint8_t>(value >> 8);
+    return true;
+}
+
+void MemoryManager::beginTick(uint64_t now) {
+    tick = now;
+}
+
+FaultResult MemoryManager::serviceFault(AddressSpace& as, bool force) {
+    PageEntry& e = as.pages[as.faultPage];
+    if (e.frame >= 0) return FaultResult::SERVICED;
+    int32_t f = takeFrame(force);
+    if (f == ALL_PINNED) return FaultResult::RETRY;
+    if (f == STORE_FULL) return FaultResult::FAILED;
+    faults.fetch_add(1, std::memory_order_relaxed);
+
+    uint8_t* data = &physical[static_cast<size_t>(f) << frameShift];
+    if (e.slot >= 0) {
+        store.read(e.slot, data); // the slot stays valid until the page is written again
+        pageIns.fetch_add(1, std::memory_order_relaxed);
+    }
+    else {
+        std::memset(data, 0, frameSize);
+    }
+    frames[f] = Frame{ &as, as.faultPage, loadSeq++, tick, true };
+    e.frame = f;
+    e.dirty = false;
+    usedFrames.fetch_add(1, std::memory_order_relaxed);
+    return FaultResult::SERVICED;
+}
+
+int32_t MemoryManager::takeFrame(bool force) {
+    if (!freeFrames.empty()) {
+        int32_t f = freeFrames.back();
+        freeFrames.pop_back();
+        return f;
+    }
+    // ties on lastUse fall back to load order, so LRU is deterministic too
+    int32_t victim = -1;
+    for (size_t f = 0; f < frames.size(); ++f) {
+        const Frame& a = frames[f];
+        if (a.pinned && !force) continue;
+        if (victim >= 0) {
+            const Frame& b = frames[victim];
+            bool older = lru ? (a.lastUse != b.lastUse ? a.lastUse < b.lastUse : a.loadSeq < b.loadSeq)
+                : a.loadSeq < b.loadSeq;
+            if (!older) continue;
+        }
+        victim = static_cast<int32_t>(f);
+    }
+    if (victim < 0) return ALL_PINNED;
+    // a dirty victim needs somewhere to go before it leaves its frame
+    PageEntry& e = frames[victim].owner->pages[frames[victim].page];
+    if (e.dirty && e.slot < 0) {
+        e.slot = store.allocateSlot();
+        storeSlots = store.getSlotsInUse();
+        if (e.slot < 0) return STORE_FULL;
+    }
+    evict(victim);
+    freeFrames.pop_back(); // evict() returned it to the free list
+    return victim;
+}
+
+void MemoryManager::evict(int32_t f) {
+    Frame& fr = frames[f];
+    PageEntry& e = fr.owner->pages[fr.page];
+    if (e.dirty) { // clean pages already match their slot, or were never written
+        if (e.slot < 0) e.slot = store.allocateSlot();
+        if (e.slot >= 0) {
+            store.write(e.slot, &physical[static_cast<size_t>(f) << frameShift]);
+            pageOuts.fetch_add(1, std::memory_order_relaxed);
+        }
+        else {
+            std::cerr << "Error: Backing store is full; a dirty page was dropped at shutdown.\n"; // takeFrame() secures a slot first
+        }
+        storeSlots = store.getSlotsInUse();
+    }
+    e.frame = -1;
+    e.dirty = false;
+    fr = Frame{};
+    freeFrames.push_back(f);
+    usedFrames.fetch_sub(1, std::memory_order_relaxed);
+    evictions.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MemoryManager::saveFrames(MemoryState& out) {
+    out.frameSize = frameSize;
+    out.nextLoadSeq = loadSeq;
+    out.frames.clear();
+    for (const Frame& f : frames) out.frames.push_back({ f.loadSeq, f.lastUse, f.pinned });
+    out.freeFrames = freeFrames;
+}
+
+void MemoryManager::savePages(const AddressSpace& as, std::vector<uint32_t>& pages, std::vector<int32_t>& inFrame,
+    std::vector<uint8_t>& data) {
+    for (uint32_t i = 0; i < as.pages.size(); ++i) {
+        const PageEntry& e = as.pages[i];
+        if (e.frame < 0 && e.slot < 0) continue; // never touched: all zero
+        size_t at = data.size();
+        data.resize(at + frameSize);
+        if (e.frame >= 0) std::memcpy(&data[at], &physical[static_cast<size_t>(e.frame) << frameShift], frameSize);
+        else store.read(e.slot, &data[at]);
+        pages.push_back(i);
+        inFrame.push_back(e.frame);
+    }
+}
+
+bool MemoryManager::loadFrames(const MemoryState& in) {
+    if (in.frameSize != frameSize || in.frames.size() != frames.size()) return false;
+    for (size_t f = 0; f < frames.size(); ++f) {
+        frames[f].loadSeq = in.frames[f].loadSeq;
+        frames[f].lastUse = in.frames[f].lastUse;
+        frames[f].pinned = in.frames[f].pinned;
+    }
+    freeFrames = in.freeFrames;
+    loadSeq = in.nextLoadSeq;
+    return true;
+}
+
+void MemoryManager::loadResident(AddressSpace& as, uint32_t page, int32_t frame) {
+    PageEntry& e = as.pages[page];
+    if (e.slot < 0 || frame < 0 || static_cast<size_t>(frame) >= frames.size()) return;
+    store.read(e.slot, &physical[static_cast<size_t>(frame) << frameShift]); // the slot stays a clean copy
+    frames[frame].owner = &as;
+    frames[frame].page = page;
+    e.frame = frame;
+    e.dirty = false;
+    usedFrames.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MemoryManager::loadBytes(AddressSpace& as, uint32_t offset, const uint8_t* data, uint32_t len) {
+    std::vector<uint8_t> page(frameSize);
+    uint32_t end = std::min(offset + len, as.size);
+    while (offset < end) {
+        PageEntry& e = as.pages[offset >> frameShift];
+        uint32_t at = offset & (frameSize - 1);
+        uint32_t n = std::min(frameSize - at, end - offset);
+        if (e.slot < 0) {
+            e.slot = store.allocateSlot();
+            if (e.slot < 0) {
+                std::cerr << "Error: Backing store is full; restored memory was dropped.\n";
+                return;
+            }
+            std::fill(page.begin(), page.end(), 0);
+        }
+        else {
+            store.read(e.slot, page.data());
+        }
+        std::memcpy(&page[at], data, n);
+        store.write(e.slot, page.data());
+        data += n;
+        offset += n;
+    }
+    storeSlots = store.getSlotsInUse();
+}
+
+VmCounters MemoryManager::getCounters() {
+    VmCounters c;
+    c.physicalBytes = physicalBytes.load(std::memory_order_relaxed);
+    c.usedBytes = usedFrames.load(std::memory_order_relaxed) * frameBytes.load(std::memory_order_relaxed);
+    c.committedBytes = committedBytes.load(std::memory_order_relaxed);
+    c.faults = faults.load(std::memory_order_relaxed);
+    c.pageIns = pageIns.load(std::memory_order_relaxed);
+    c.pageOuts = pageOuts.load(std::memory_order_relaxed);
+    c.evictions = evictions.load(std::memory_order_relaxed);
+    c.storePages = storeSlots.load(std::memory_order_relaxed);
+    return c;
+}
+
+void MemoryManager::printVmstat() {
+    uint64_t total = physical.size();
+    uint64_t used = usedFrames.load(std::memory_order_relaxed) * frameSize;
+    uint64_t committed = committedBytes.load(std::memory_order_relaxed);
+    uint64_t faultCount = faults.load(std::memory_order_relaxed);
+    uint64_t ticks = Scheduler::getCurrentTick() - startTick;
+    size_t spaceCount;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        spaceCount = spaces.size();
+    }
+
+    std::cout << "===== Virtual Memory Statistics =====\n";
+    std::cout << "  total memory:    " << total << " bytes (" << frames.size() << " frames of "
+        << frameSize << ")\n";
+    std::cout << "  used memory:     " << used << " bytes\n";
+    std::cout << "  free memory:     " << total - std::min(used, total) << " bytes\n";
+    std::cout << "  committed:       " << committed << " bytes in " << spaceCount << " address spaces";
+    if (total > 0) {
+        std::cout << std::fixed << std::setprecision(2) << " (" << static_cast<double>(committed) / total
+            << "x physical)" << std::defaultfloat;
+    }
+    std::cout << "\n";
+    std::cout << "  replacement:     " << (lru ? "lru" : "fifo") << "\n";
+    std::cout << "  page faults:     " << faultCount << "\n";
+    std::cout << "  pages paged in:  " << pageIns.load(std::memory_order_relaxed) << "\n";
+    std::cout << "  pages paged out: " << pageOuts.load(std::memory_order_relaxed) << "\n";
+    std::cout << "  evictions:       " << evictions.load(std::memory_order_relaxed) << "\n";
+    std::cout << "  backing store:   " << store.getPath() << " (" << storeSlots.load(std::memory_order_relaxed)
+        << " pages)\n";
+    std::cout << "  pressure:        " << std::fixed << std::setprecision(2)
+        << (ticks ? 100.0 * faultCount / ticks : 0.0) << " faults per 100 ticks\n" << std::defaultfloat;
+    std::cout << "=====================================\n";
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "BackingStore.h"
+
+struct PageEntry {
+    int32_t frame = -1; // -1 while the page is not resident
+    int32_t slot = -1;  // backing-store copy, -1 until the page is first paged out
+    bool dirty = false; // written since it was paged in
+};
+
+// A process's emulated address space. Cores translate through it while they run the
+// process; the mapping only changes on the scheduler thread, between ticks.
+struct AddressSpace {
+    uint32_t size = 0; // bytes
+    std::vector<PageEntry> pages;
+    uint32_t faultPage = 0; // set by the core when an access misses
+};
+
+// Frame table as a checkpoint saves it. Which page sits in a frame comes from the
+// page tables, so only the replacement bookkeeping is here.
+struct MemoryState {
+    struct FrameInfo {
+        uint64_t loadSeq;
+        uint64_t lastUse;
+        bool pinned;
+    };
+    uint32_t frameSize = 0;
+    uint64_t nextLoadSeq = 0;
+    std::vector<FrameInfo> frames;
+    std::vector<int32_t> freeFrames; // in the order they will be handed out
+};
+
+// Running totals of the frame pool and paging; read without locks by the metrics exporter.
+struct VmCounters {
+    uint64_t physicalBytes;
+    uint64_t usedBytes;
+    uint64_t committedBytes;
+    uint64_t faults;
+    uint64_t pageIns;
+    uint64_t pageOuts;
+    uint64_t evictions;
+    uint64_t storePages;
+};
+
+enum class FaultResult {
+    SERVICED,
+    RETRY,  // every frame is pinned (with force: there are no frames); fault again next tick
+    FAILED, // the victim is dirty and the backing store cannot grow; it stays resident
+};
+
+// Global physical memory split into fixed-size frames, with demand paging and FIFO or
+// LRU replacement. A miss does not take a lock on the core: the access reports it, the
+// scheduler pages in between ticks, and the process keeps its core and retries at the
+// next tick, so the frames every run picks do not depend on thread timing.
+//
+// The page stays pinned until its owner touches it, so the faults serviced after it
+// in the same tick cannot take it back. Were the process to go back to the ready
+// queue instead, its page could be evicted again before it ran, and with more
+// faulting processes than frames nothing would progress.
+//
+// A dirty victim gets its backing-store slot before it is evicted. When the store
+// cannot grow the victim stays resident and the fault fails its process instead.
+class MemoryManager {
+public:
+    static constexpr int PAGE_FAULT_TICKS = 1; // the faulting core stalls for this tick
+
+    static bool initialize(); // (re)builds the frame pool from the loaded config; false without a backing store
+    static void shutdown();   // writes resident pages back so the next pool can fault them in
+
+    static void attach(AddressSpace& as, uint32_t bytes); // any thread
+    static void release(AddressSpace& as); // scheduler thread: frees the frames and slots
+
+    // Core thread, while running the owner. False means a page fault and as.faultPage
+    // names the page to bring in. Throws std::out_of_range on an access violation.
+    static bool tryRead(AddressSpace& as, uint32_t addr, uint16_t& value);
+    static bool tryWrite(AddressSpace& as, uint32_t addr, uint16_t value);
+
+    // Scheduler thread only.
+    static void beginTick(uint64_t tick);
+    static FaultResult serviceFault(AddressSpace& as, bool force = false);
+
+    // Checkpoint support. savePages copies out every page with contents, resident or
+    // stored, with the frame it is in or -1 (scheduler thread). loadBytes puts saved
+    // contents in the backing store; when loadFrames accepted the saved frame table,
+    // loadResident then pages them back into the same frames (scheduler stopped).
+    static void saveFrames(MemoryState& out);
+    static void savePages(const AddressSpace& as, std::vector<uint32_t>& pages, std::vector<int32_t>& inFrame,
+        std::vector<uint8_t>& data);
+    static bool loadFrames(const MemoryState& in); // false when the frame geometry changed
+    static void loadBytes(AddressSpace& as, uint32_t offset, const uint8_t* data, uint32_t len);
+    static void loadResident(AddressSpace& as, uint32_t page, int32_t frame);
+    static uint32_t getFrameSize() { return frameSize; }
+
+    static void printVmstat();
+    static VmCounters getCounters(); // any thread
+
+private:
+    struct Frame {
+        AddressSpace* owner = nullptr;
+        uint32_t page = 0;
+        uint64_t loadSeq = 0; // FIFO order
+        uint64_t lastUse = 0; // LRU: tick of the last access, written by the owner's core
+        bool pinned = false;  // paged in and not yet touched by the owner
+    };
+
+    static std::vector<uint8_t> physical;
+    static std::vector<Frame> frames;
+    static std::vector<int32_t> freeFrames;
+    static uint32_t frameSize;
+    static int frameShift;
+    static bool lru;
+    static uint64_t loadSeq;
+    static uint64_t tick;
+    static uint64_t startTick;
+    static BackingStore store;
+
+    static std::mutex registryMutex;
+    static std::vector<AddressSpace*> spaces;
+
+    static std::atomic<uint64_t> faults;
+    static std::atomic<uint64_t> pageIns;
+    static std::atomic<uint64_t> pageOuts;
+    static std::atomic<uint64_t> evictions;
+    static std::atomic<uint64_t> usedFrames;
+    static std::atomic<uint64_t> committedBytes;
+    static std::atomic<uint64_t> storeSlots;
+    static std::atomic<uint64_t> physicalBytes; // physical.size() and frameSize, for other threads
+    static std::atomic<uint64_t> frameBytes;
+
+    static uint8_t* translate(AddressSpace& as, uint32_t addr, bool write);
+    static constexpr int32_t ALL_PINNED = -1;
+    static constexpr int32_t STORE_FULL = -2;
+    static int32_t takeFrame(bool force); // a free frame, ALL_PINNED (only when !force) or STORE_FULL
+    static void evict(int32_t frame);
+    static uint32_t pagesFor(uint32_t bytes) { return (bytes + frameSize - 1) >> frameShift; }
+};
@@ -0,0 +1,272 @@
+#include "MemoryPool.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+    AllocStats arenaStats;
+
+    size_t alignUp(size_t v, size_t align) {
+        return (v + align - 1) & ~(align - 1);
+    }
+
+    std::mutex& registryMutex() {
+        static std::mutex m;
+        return m;
+    }
+
+    std::vector<const FixedPool*>& registry() {
+        static std::vector<const FixedPool*> pools;
+        return pools;
+    }
+}
+
+// ---------- Arena ----------
+
+Arena::Arena(size_t blockSize) : head(nullptr), blockSize(blockSize), used(0) {
+}
+
+Arena::~Arena() {
+    while (head) {
+        Block* next = head->next;
+        arenaStats.bytes_reserved.fetch_sub(head->size, std::memory_order_relaxed);
+        ::operator delete(head);
+        head = next;
+    }
+    arenaStats.bytes_in_use.fetch_sub(used, std::memory_order_relaxed);
+}
+
+Arena::Block* Arena::newBlock(size_t minBytes) {
+    size_t size = std::max(blockSize, alignUp(sizeof(Block), alignof(std::max_align_t)) + minBytes);
+    Block* b = static_cast<Block*>(::operator new(size));
+    b->next = head;
+    b->size = size;
+    b->used = alignUp(sizeof(Block), alignof(std::max_align_t));
+    head = b;
+    arenaStats.heap_refills.fetch_add(1, std::memory_order_relaxed);
+    arenaStats.bytes_reserved.fetch_add(size, std::memory_order_relaxed);
+    return b;
+}
+
+void* Arena::allocate(size_t bytes, size_t align) {
+    if (!head) newBlock(bytes + align);
+
+    size_t base = reinterpret_cast<size_t>(head);
+    size_t start = alignUp(base + head->used, align) - base;
+    if (start + bytes > head->size) {
+        newBlock(bytes + align);
+        base = reinterpret_cast<size_t>(head);
+        start = alignUp(base + head->used, align) - base;
+    }
+
+    head->used = start + bytes;
+    used += bytes;
+    arenaStats.allocations.fetch_add(1, std::memory_order_relaxed);
+    arenaStats.bytes_in_use.fetch_add(bytes, std::memory_order_relaxed);
+    return reinterpret_cast<char*>(head) + start;
+}
+
+void Arena::reset() {
+    if (!head) return;
+    // the oldest block is the last in the list; keep it and free the rest
+    while (head->next) {
+        Block* next = head->next;
+        arenaStats.bytes_reserved.fetch_sub(head->size, std::memory_order_relaxed);
+        ::operator delete(head);
+        head = next;
+    }
+    head->used = alignUp(sizeof(Block), alignof(std::max_align_t));
+    arenaStats.bytes_in_use.fetch_sub(used, std::memory_order_relaxed);
+    used = 0;
+}
+
+size_t Arena::bytesUsed() const { return used; }
+
+const AllocStats& Arena::stats() { return arenaStats; }
+
+// ---------- FixedPool ----------
+
+FixedPool::FixedPool(size_t objectSize, size_t objectsPerSlab, const char* name)
+    : freeList(nullptr), slabs(nullptr),
+    objectSize(alignUp(std::max(objectSize, sizeof(FreeNode)), alignof(std::max_align_t))),
+    objectsPerSlab(std::max<size_t>(objectsPerSlab, 1)), name(name) {
+    AllocatorStats::registerPool(this);
+}
+
+FixedPool::~FixedPool() {
+    AllocatorStats::unregisterPool(this);
+    while (slabs) {
+        Slab* next = slabs->next;
+        ::operator delete(slabs);
+        slabs = next;
+    }
+}
+
+void FixedPool::grow() {
+    size_t header = alignUp(sizeof(Slab), alignof(std::max_align_t));
+    size_t bytes = header + objectSize * objectsPerSlab;
+    Slab* slab = static_cast<Slab*>(::operator new(bytes));
+    slab->next = slabs;
+    slabs = slab;
+
+    char* first = reinterpret_cast<char*>(slab) + header;
+    for (size_t i = objectsPerSlab; i-- > 0;) {
+        FreeNode* node = reinterpret_cast<FreeNode*>(first + i * objectSize);
+        node->next = freeList;
+        freeList = node;
+    }
+    stats.heap_refills.fetch_add(1, std::memory_order_relaxed);
+    stats.bytes_reserved.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void* FixedPool::allocate() {
+    void* p = nullptr;
+    allocateBatch(&p, 1);
+    return p;
+}
+
+void FixedPool::deallocate(void* p) {
+    if (p) deallocateBatch(&p, 1);
+}
+
+size_t FixedPool::allocateBatch(void** out, size_t n) {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (size_t i = 0; i < n; ++i) {
+        if (!freeList) grow();
+        out[i] = freeList;
+        freeList = freeList->next;
+    }
+    stats.allocations.fetch_add(n, std::memory_order_relaxed);
+    stats.bytes_in_use.fetch_add(n * objectSize, std::memory_order_relaxed);
+    return n;
+}
+
+void FixedPool::deallocateBatch(void** in, size_t n) {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (size_t i = 0; i < n; ++i) {
+        FreeNode* node = static_cast<FreeNode*>(in[i]);
+        node->next = freeList;
+        freeList = node;
+    }
+    stats.deallocations.fetch_add(n, std::memory_order_relaxed);
+    stats.bytes_in_use.fetch_sub(n * objectSize, std::memory_order_relaxed);
+}
+
+// ---------- LogRecordPool ----------
+
+LogRecordPool::CoreCache LogRecordPool::caches[LogRecordPool::MAX_CORES];
+thread_local int LogRecordPool::currentCore = -1;
+
+FixedPool& LogRecordPool::shared() {
+    static FixedPool pool(sizeof(LogRecord), 4096, "log records");
+    return pool;
+}
+
+void LogRecordPool::setCurrentCore(int core) {
+    currentCore = (core >= 0 && core < MAX_CORES) ? core : -1;
+}
+
+LogRecord* LogRecordPool::acquire() {
+    if (currentCore < 0) {
+        return static_cast<LogRecord*>(shared().allocate());
+    }
+
+    CoreCache& cache = caches[currentCore];
+    if (!cache.head) {
+        void* batch[BATCH];
+        size_t got = shared().allocateBatch(batch, BATCH);
+        for (size_t i = 0; i < got; ++i) {
+            LogRecord* r = static_cast<LogRecord*>(batch[i]);
+            r->next = cache.head;
+            cache.head = r;
+        }
+        cache.count += got;
+        cache.misses.store(cache.misses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    else {
+        cache.hits.store(cache.hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    LogRecord* r = cache.head;
+    cache.head = r->next;
+    cache.count--;
+    return r;
+}
+
+void LogRecordPool::release(LogRecord* r) {
+    if (!r) return;
+    if (currentCore < 0) {
+        shared().deallocate(r);
+        return;
+    }
+
+    CoreCache& cache = caches[currentCore];
+    r->next = cache.head;
+    cache.head = r;
+    cache.count++;
+
+    if (cache.count > HIGH_WATER) {
+        void* batch[BATCH];
+        for (size_t i = 0; i < BATCH; ++i) {
+            batch[i] = cache.head;
+            cache.head = cache.head->next;
+        }
+        cache.count -= BATCH;
+        shared().deallocateBatch(batch, BATCH);
+    }
+}
+
+uint64_t LogRecordPool::getCacheHits() {
+    uint64_t total = 0;
+    for (const auto& c : caches) total += c.hits.load(std::memory_order_relaxed);
+    return total;
+}
+
+uint64_t LogRecordPool::getCacheMisses() {
+    uint64_t total = 0;
+    for (const auto& c : caches) total += c.misses.load(std::memory_order_relaxed);
+    return total;
+}
+
+// ---------- AllocatorStats ----------
+
+void AllocatorStats::registerPool(const FixedPool* pool) {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    registry().push_back(pool);
+}
+
+void AllocatorStats::unregisterPool(const FixedPool* pool) {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    auto& pools = registry();
+    pools.erase(std::remove(pools.begin(), pools.end(), pool), pools.end());
+}
+
+static void printRow(const std::string& name, const AllocStats& s) {
+    std::cout << "  " << std::left << std::setw(20) << name << std::right
+        << std::setw(12) << s.allocations.load(std::memory_order_relaxed)
+        << std::setw(12) << s.deallocations.load(std::memory_order_relaxed)
+        << std::setw(14) << s.bytes_in_use.load(std::memory_order_relaxed)
+        << std::setw(14) << s.bytes_reserved.load(std::memory_order_relaxed)
+        << std::setw(10) << s.heap_refills.load(std::memory_order_relaxed) << "\n";
+}
+
+void AllocatorStats::print() {
+    std::cout << "===== Allocator Statistics =====\n";
+    std::cout << "  " << std::left << std::setw(20) << "allocator" << std::right
+        << std::setw(12) << "allocs" << std::setw(12) << "frees"
+        << std::setw(14) << "bytes used" << std::setw(14) << "bytes rsvd"
+        << std::setw(10) << "refills" << "\n";
+
+    printRow("arenas", Arena::stats());
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        for (const FixedPool* pool : registry()) {
+            printRow(pool->getName(), pool->getStats());
+        }
+    }
+
+    std::cout << "  log record core cache: " << LogRecordPool::getCacheHits() << " hits, "
+        << LogRecordPool::getCacheMisses() << " refills\n";
+    std::cout << "================================\n";
+}
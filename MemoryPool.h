@@ -0,0 +1,208 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// Counters kept by every allocator in this file. Relaxed atomics, only read by alloc-stats.
+struct AllocStats {
+    std::atomic<uint64_t> allocations{ 0 };
+    std::atomic<uint64_t> deallocations{ 0 };
+    std::atomic<uint64_t> bytes_in_use{ 0 };
+    std::atomic<uint64_t> bytes_reserved{ 0 };
+    std::atomic<uint64_t> heap_refills{ 0 }; // times we had to go back to the global heap
+};
+
+// Bump allocator. Memory is only given back when the arena is reset or destroyed,
+// so it is meant for data that dies together (e.g. the instruction streams of one batch).
+// Not thread-safe: one arena is filled by one thread.
+class Arena {
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    explicit Arena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+    void reset(); // keeps the first block for reuse
+    size_t bytesUsed() const;
+
+    static const AllocStats& stats(); // totals across all arenas
+
+private:
+    struct Block {
+        Block* next;
+        size_t size;
+        size_t used;
+    };
+
+    Block* head;
+    size_t blockSize;
+    size_t used;
+
+    Block* newBlock(size_t minBytes);
+};
+
+// STL adaptor over an Arena. A null arena falls back to the global heap so containers
+// built outside of a batch (manual screen instructions) still work.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    ArenaAllocator() noexcept : arena(nullptr) {}
+    explicit ArenaAllocator(Arena* a) noexcept : arena(a) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.getArena()) {}
+
+    T* allocate(size_t n) {
+        if (arena) return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t) noexcept {
+        if (!arena) ::operator delete(p);
+    }
+
+    Arena* getArena() const noexcept { return arena; }
+
+private:
+    Arena* arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept {
+    return a.getArena() == b.getArena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept {
+    return !(a == b);
+}
+
+// Fixed-size block pool. Blocks are carved out of slabs and recycled through a freelist,
+// so after warm-up allocate/deallocate never touch the global heap.
+class FixedPool {
+public:
+    FixedPool(size_t objectSize, size_t objectsPerSlab, const char* name);
+    ~FixedPool();
+    FixedPool(const FixedPool&) = delete;
+    FixedPool& operator=(const FixedPool&) = delete;
+
+    void* allocate();
+    void deallocate(void* p);
+
+    // Move up to n blocks in or out under a single lock (used by per-core caches).
+    size_t allocateBatch(void** out, size_t n);
+    void deallocateBatch(void** in, size_t n);
+
+    size_t getObjectSize() const { return objectSize; }
+    const char* getName() const { return name; }
+    const AllocStats& getStats() const { return stats; }
+
+private:
+    struct FreeNode { FreeNode* next; };
+    struct Slab { Slab* next; };
+
+    std::mutex mtx;
+    FreeNode* freeList;
+    Slab* slabs;
+    size_t objectSize;
+    size_t objectsPerSlab;
+    const char* name;
+    AllocStats stats;
+
+    void grow(); // caller holds mtx
+};
+
+// Typed wrapper over FixedPool.
+template <typename T>
+class ObjectPool {
+public:
+    ObjectPool(size_t objectsPerSlab, const char* name) : pool(sizeof(T), objectsPerSlab, name) {
+        static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "over-aligned pool type");
+    }
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        void* mem = pool.allocate();
+        try {
+            return new (mem) T(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            pool.deallocate(mem);
+            throw;
+        }
+    }
+
+    void destroy(T* p) {
+        if (!p) return;
+        p->~T();
+        pool.deallocate(p);
+    }
+
+    const AllocStats& getStats() const { return pool.getStats(); }
+
+private:
+    FixedPool pool;
+};
+
+constexpr size_t LOG_TEXT_MAX = 112;
+
+// One process log line, or a piece of it: a longer line continues in the records that
+// follow, each but the last marked more. Fixed size so records can be recycled through
+// freelists.
+struct LogRecord {
+    LogRecord* next;
+    uint16_t len;
+    bool more;
+    char text[LOG_TEXT_MAX];
+
+    std::string_view view() const { return std::string_view(text, len); }
+};
+
+// Log records come from a per-core freelist, refilled in batches from a shared pool.
+// Threads that are not cores (the shell) go straight to the shared pool.
+class LogRecordPool {
+public:
+    static constexpr int MAX_CORES = 128;
+
+    static LogRecord* acquire();
+    static void release(LogRecord* r);
+    static void setCurrentCore(int core); // -1 = not a core thread
+
+    static uint64_t getCacheHits();
+    static uint64_t getCacheMisses();
+
+private:
+    static constexpr size_t BATCH = 64;
+    static constexpr size_t HIGH_WATER = 4 * BATCH;
+
+    struct alignas(64) CoreCache {
+        LogRecord* head = nullptr;
+        size_t count = 0;
+        std::atomic<uint64_t> hits{ 0 };   // single writer (the owning core)
+        std::atomic<uint64_t> misses{ 0 };
+    };
+
+    static FixedPool& shared();
+    static CoreCache caches[MAX_CORES];
+    static thread_local int currentCore;
+};
+
+class AllocatorStats {
+public:
+    static void registerPool(const FixedPool* pool);
+    static void unregisterPool(const FixedPool* pool);
+    static void print();
+};
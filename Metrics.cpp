@@ -0,0 +1,328 @@
+#include "Metrics.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include "MemoryManager.h"
+#include "Scheduler.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+using Socket = SOCKET;
+static void closeSocket(Socket s) { closesocket(s); }
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+using Socket = int;
+static void closeSocket(Socket s) { ::close(s); }
+#endif
+
+#ifdef MSG_NOSIGNAL
+static constexpr int SEND_FLAGS = MSG_NOSIGNAL; // a reset scraper must not raise SIGPIPE
+#else
+static constexpr int SEND_FLAGS = 0;
+#endif
+
+std::thread Metrics::server;
+std::thread Metrics::fileWriter;
+std::atomic<bool> Metrics::serving{ false };
+intptr_t Metrics::listener = -1;
+int Metrics::port = 0;
+std::mutex Metrics::mtx;
+std::condition_variable Metrics::wake;
+bool Metrics::writing = false;
+std::string Metrics::path;
+int Metrics::intervalMs = Metrics::DEFAULT_INTERVAL_MS;
+std::atomic<uint64_t> Metrics::filesWritten{ 0 };
+std::atomic<uint64_t> Metrics::requestsServed{ 0 };
+
+namespace {
+    // Appends one metric family: HELP and TYPE lines, then its samples.
+    class Exposition {
+    public:
+        void family(const char* name, const char* type, const char* help) {
+            current = name;
+            out += "# HELP ";
+            out += name;
+            out += ' ';
+            out += help;
+            out += "\n# TYPE ";
+            out += name;
+            out += ' ';
+            out += type;
+            out += '\n';
+        }
+        void sample(uint64_t v, const std::string& labels = "") {
+            line(labels);
+            out += std::to_string(v);
+            out += '\n';
+        }
+        void sample(double v, const std::string& labels = "") {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.6g", v);
+            line(labels);
+            out += buf;
+            out += '\n';
+        }
+        std::string take() { return std::move(out); }
+
+    private:
+        std::string out;
+        const char* current = "";
+
+        void line(const std::string& labels) {
+            out += current;
+            if (!labels.empty()) {
+                out += '{';
+                out += labels;
+                out += '}';
+            }
+            out += ' ';
+        }
+    };
+
+    std::string coreLabel(int id) {
+        return "core=\"" + std::to_string(id) + "\"";
+    }
+}
+
+std::string Metrics::render() {
+    std::vector<CoreCounters> cores;
+    Scheduler::readCoreCounters(cores);
+    VmCounters vm = MemoryManager::getCounters();
+    uint64_t instructions = 0;
+    for (const CoreCounters& c : cores) instructions += c.instructions;
+
+    Exposition e;
+    e.family("csopesy_ticks_total", "counter", "CPU ticks elapsed.");
+    e.sample(Scheduler::getCurrentTick());
+    e.family("csopesy_processes_live", "gauge", "Processes admitted and not yet finished.");
+    e.sample(static_cast<uint64_t>(Scheduler::getLiveProcesses()));
+    e.family("csopesy_processes_finished_total", "counter", "Processes finished under the current policy.");
+    e.sample(Scheduler::getFinishedCount());
+    e.family("csopesy_processes_generated_total", "counter", "Processes created by the generator.");
+    e.sample(Scheduler::getGeneratedCount());
+    e.family("csopesy_arrivals_paused_total", "counter", "Arrivals skipped by max-live-processes.");
+    e.sample(Scheduler::getPausedArrivals());
+    e.family("csopesy_waiting_ticks_avg", "gauge", "Average ticks a finished process spent ready but not on a core.");
+    e.sample(Scheduler::getAvgWaitingTicks());
+    e.family("csopesy_turnaround_ticks_avg", "gauge", "Average ticks from arrival to finish.");
+    e.sample(Scheduler::getAvgTurnaroundTicks());
+
+    e.family("csopesy_cores", "gauge", "Emulated CPU cores.");
+    e.sample(static_cast<uint64_t>(cores.size()));
+    e.family("csopesy_cores_busy", "gauge", "Cores holding a process at the last tick.");
+    e.sample(static_cast<uint64_t>(Scheduler::getBusyCores()));
+    e.family("csopesy_core_busy_ticks_total", "counter", "Ticks the core spent running a process.");
+    for (const CoreCounters& c : cores) e.sample(c.busyTicks, coreLabel(c.id));
+    e.family("csopesy_core_utilization", "gauge", "Busy share of the ticks since the core started.");
+    for (const CoreCounters& c : cores) e.sample(c.utilization, coreLabel(c.id));
+    e.family("csopesy_core_instructions_total", "counter", "Instructions the core executed.");
+    for (const CoreCounters& c : cores) e.sample(c.instructions, coreLabel(c.id));
+    e.family("csopesy_instructions_total", "counter", "Instructions executed by all cores.");
+    e.sample(instructions);
+    e.family("csopesy_context_switches_total", "counter", "Processes dispatched onto a core.");
+    e.sample(Scheduler::getContextSwitches());
+
+    e.family("csopesy_ready_queue_depth", "gauge", "Processes ready and waiting for a core.");
+    e.sample(static_cast<uint64_t>(Scheduler::getReadyCount()));
+    e.family("csopesy_sleep_queue_depth", "gauge", "Processes sleeping.");
+    e.sample(static_cast<uint64_t>(Scheduler::getSleepingCount()));
+
+    e.family("csopesy_memory_physical_bytes", "gauge", "Size of emulated physical memory.");
+    e.sample(vm.physicalBytes);
+    e.family("csopesy_memory_used_bytes", "gauge", "Physical memory held by resident pages.");
+    e.sample(vm.usedBytes);
+    e.family("csopesy_memory_committed_bytes", "gauge", "Memory allocated to live address spaces.");
+    e.sample(vm.committedBytes);
+    e.family("csopesy_page_faults_total", "counter", "Page faults.");
+    e.sample(vm.faults);
+    e.family("csopesy_pages_in_total", "counter", "Pages read from the backing store.");
+    e.sample(vm.pageIns);
+    e.family("csopesy_pages_out_total", "counter", "Pages written to the backing store.");
+    e.sample(vm.pageOuts);
+    e.family("csopesy_page_evictions_total", "counter", "Resident pages evicted.");
+    e.sample(vm.evictions);
+    e.family("csopesy_backing_store_pages", "gauge", "Pages held in the backing store.");
+    e.sample(vm.storePages);
+    return e.take();
+}
+
+// ---------- HTTP ----------
+
+namespace {
+    // Waits up to the timeout for the socket to become readable.
+    bool readable(Socket s, long timeoutUs) {
+        fd_set ready;
+        FD_ZERO(&ready);
+        FD_SET(s, &ready);
+        timeval timeout{ 0, timeoutUs };
+        return select(static_cast<int>(s) + 1, &ready, nullptr, nullptr, &timeout) > 0;
+    }
+}
+
+bool Metrics::serve(int p) {
+    if (serving) {
+        std::cout << "Metrics are already served on port " << port << ".\n";
+        return false;
+    }
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        std::cerr << "Error: Cannot initialize Winsock\n";
+        return false;
+    }
+#endif
+    Socket s = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (static_cast<intptr_t>(s) < 0) {
+        std::cerr << "Error: Cannot create the metrics socket\n";
+        return false;
+    }
+    int yes = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR,
+        reinterpret_cast<const char*>(&yes), sizeof(yes));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(p));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(s, 8) != 0) {
+        std::cerr << "Error: Cannot listen on 127.0.0.1:" << p << "\n";
+        closeSocket(s);
+        return false;
+    }
+    listener = static_cast<intptr_t>(s);
+    port = p;
+    requestsServed = 0;
+    serving = true;
+    server = std::thread(serverLoop);
+    std::cout << "Serving metrics on http://127.0.0.1:" << port << "/metrics\n";
+    return true;
+}
+
+// One request per connection; the poll timeout lets stop() end the loop. A client
+// that sends nothing within CLIENT_TIMEOUT_US is dropped, so it cannot hold up stop().
+void Metrics::serverLoop() {
+    Socket sock = static_cast<Socket>(listener);
+    while (serving) {
+        if (!readable(sock, 200000)) continue;
+        Socket client = accept(sock, nullptr, nullptr);
+        if (static_cast<intptr_t>(client) < 0) continue;
+        if (!readable(client, CLIENT_TIMEOUT_US)) {
+            closeSocket(client);
+            continue;
+        }
+
+        char buf[1024];
+        int n = static_cast<int>(recv(client, buf, sizeof(buf) - 1, 0));
+        std::string request(buf, n > 0 ? n : 0);
+        std::string response;
+        if (request.rfind("GET /metrics", 0) == 0 || request.rfind("GET / ", 0) == 0) {
+            std::string body = render();
+            response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                "Content-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+            requestsServed++;
+        }
+        else {
+            response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        }
+        for (size_t sent = 0; sent < response.size(); ) {
+            int w = static_cast<int>(send(client, response.data() + sent, static_cast<int>(response.size() - sent), SEND_FLAGS));
+            if (w <= 0) break;
+            sent += static_cast<size_t>(w);
+        }
+        closeSocket(client);
+    }
+}
+
+// ---------- File ----------
+
+bool Metrics::writeTo(const std::string& file, int interval) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (writing) {
+            std::cout << "Metrics are already written to " << path << ".\n";
+            return false;
+        }
+        path = file;
+        intervalMs = interval > 0 ? interval : DEFAULT_INTERVAL_MS;
+        filesWritten = 0;
+    }
+    if (!writeFile()) return false;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        writing = true;
+    }
+    fileWriter = std::thread(fileLoop);
+    std::cout << "Writing metrics to " << file << " every " << intervalMs << " ms\n";
+    return true;
+}
+
+void Metrics::fileLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (writing) {
+        if (wake.wait_for(lock, std::chrono::milliseconds(intervalMs), [] { return !writing; })) break;
+        lock.unlock();
+        writeFile();
+        lock.lock();
+    }
+}
+
+// Written aside and renamed over the target, so a scraper never reads half a file.
+bool Metrics::writeFile() {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc | std::ios::binary);
+        if (!out) {
+            std::cerr << "Error: Cannot write metrics to '" << tmp << "'\n";
+            return false;
+        }
+        out << render();
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::cerr << "Error: Cannot replace '" << path << "': " << ec.message() << "\n";
+        return false;
+    }
+    filesWritten++;
+    return true;
+}
+
+// ---------- Control ----------
+
+void Metrics::stop() {
+    if (serving.exchange(false)) {
+        server.join();
+        closeSocket(static_cast<Socket>(listener));
+        listener = -1;
+#ifdef _WIN32
+        WSACleanup();
+#endif
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        writing = false;
+    }
+    wake.notify_all();
+    if (fileWriter.joinable()) fileWriter.join();
+}
+
+void Metrics::printStatus() {
+    std::cout << "===== Metrics Export =====\n";
+    if (serving) std::cout << "  http: 127.0.0.1:" << port << "/metrics (" << requestsServed << " scrapes)\n";
+    else std::cout << "  http: off\n";
+    std::lock_guard<std::mutex> lock(mtx);
+    if (writing) std::cout << "  file: " << path << " every " << intervalMs << " ms (" << filesWritten << " written)\n";
+    else std::cout << "  file: off\n";
+    std::cout << "==========================\n";
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Prometheus text exposition of the emulator's running counters: processes, per-core
+// utilization and instructions, context switches, queue depths and memory. Everything
+// it reads is an atomic the scheduler, the cores or the memory manager already keep,
+// so exporting adds nothing to the execution path. It is served over HTTP on
+// localhost, written to a file every interval (for a textfile collector), or both.
+class Metrics {
+public:
+    static constexpr int DEFAULT_INTERVAL_MS = 5000;
+
+    static bool serve(int port);
+    static bool writeTo(const std::string& path, int intervalMs = DEFAULT_INTERVAL_MS);
+    static void stop();
+    static void printStatus();
+    static std::string render();
+
+private:
+    static constexpr long CLIENT_TIMEOUT_US = 500000;
+
+    static std::thread server;
+    static std::thread fileWriter;
+    static std::atomic<bool> serving;
+    static intptr_t listener; // the platform socket handle
+    static int port;
+    static std::mutex mtx; // stop() and the file writer's interval wait
+    static std::condition_variable wake;
+    static bool writing;
+    static std::string path;
+    static int intervalMs;
+    static std::atomic<uint64_t> filesWritten;
+    static std::atomic<uint64_t> requestsServed;
+
+    static void serverLoop();
+    static void fileLoop();
+    static bool writeFile();
+};
@@ -0,0 +1,176 @@
+#include "PerfCounters.h"
+#include <algorithm>
+#include <bit>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "Process.h"
+#include "ProcessGenerator.h"
+
+static_assert(PerfCounters::OPCODES == Instruction::WRITE + 1, "one counter per Instruction::Type");
+
+PerfCounters::OpCounters PerfCounters::slots[PerfCounters::MAX_CORES + 1];
+thread_local int PerfCounters::currentSlot = PerfCounters::MAX_CORES;
+LatencyHistogram PerfCounters::dispatch;
+LatencyHistogram PerfCounters::admission;
+PerfCounters::Gauge PerfCounters::ready;
+PerfCounters::Gauge PerfCounters::sleeping;
+PerfCounters::Gauge PerfCounters::busyCores;
+std::atomic<uint64_t> PerfCounters::samples{ 0 };
+
+// ---------- LatencyHistogram ----------
+
+void LatencyHistogram::record(uint64_t ns) {
+    int b = std::min(BUCKETS - 1, ns ? static_cast<int>(std::bit_width(ns)) - 1 : 0);
+    buckets[b].store(buckets[b].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    sum_ns.store(sum_ns.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    if (ns > max_ns.load(std::memory_order_relaxed)) max_ns.store(ns, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset() {
+    for (auto& b : buckets) b.store(0, std::memory_order_relaxed);
+    count.store(0, std::memory_order_relaxed);
+    sum_ns.store(0, std::memory_order_relaxed);
+    max_ns.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    uint64_t n = count.load(std::memory_order_relaxed);
+    if (n == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(p * static_cast<double>(n - 1)) + 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < BUCKETS; ++b) {
+        seen += buckets[b].load(std::memory_order_relaxed);
+        if (seen >= rank) return std::min((uint64_t{ 2 } << b) - 1, max_ns.load(std::memory_order_relaxed));
+    }
+    return max_ns.load(std::memory_order_relaxed);
+}
+
+// ---------- PerfCounters ----------
+
+void PerfCounters::Gauge::sample(uint64_t v) {
+    last.store(v, std::memory_order_relaxed);
+    sum.store(sum.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+    if (v > max.load(std::memory_order_relaxed)) max.store(v, std::memory_order_relaxed);
+}
+
+void PerfCounters::Gauge::reset() {
+    last.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+}
+
+void PerfCounters::setCurrentCore(int core) {
+    currentSlot = (core >= 0 && core < MAX_CORES) ? core : MAX_CORES;
+}
+
+void PerfCounters::sample(size_t readyCount, size_t sleepingCount, int busy) {
+    ready.sample(readyCount);
+    sleeping.sample(sleepingCount);
+    busyCores.sample(static_cast<uint64_t>(busy));
+    samples.store(samples.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void PerfCounters::reset() {
+    for (OpCounters& s : slots) {
+        for (auto& c : s.count) c.store(0, std::memory_order_relaxed);
+        for (auto& c : s.ns) c.store(0, std::memory_order_relaxed);
+        s.contextSwitch.reset();
+    }
+    dispatch.reset();
+    admission.reset();
+    ready.reset();
+    sleeping.reset();
+    busyCores.reset();
+    samples.store(0, std::memory_order_relaxed);
+}
+
+static void printLatencyRow(const std::string& what, const LatencyHistogram& h) {
+    uint64_t n = h.count.load(std::memory_order_relaxed);
+    std::cout << "  " << std::left << std::setw(16) << what << std::right << std::setw(12) << n
+        << std::setw(10) << (n ? h.sum_ns.load(std::memory_order_relaxed) / n : 0)
+        << std::setw(10) << h.percentile(0.5) << std::setw(10) << h.percentile(0.9)
+        << std::setw(10) << h.percentile(0.99) << std::setw(12) << h.max_ns.load(std::memory_order_relaxed) << "\n";
+}
+
+static void printHistogramBars(const std::string& what, const LatencyHistogram& h) {
+    uint64_t n = h.count.load(std::memory_order_relaxed);
+    if (n == 0) return;
+    std::cout << "  " << what << ":\n";
+    for (int b = 0; b < LatencyHistogram::BUCKETS; ++b) {
+        uint64_t c = h.buckets[b].load(std::memory_order_relaxed);
+        if (c == 0) continue;
+        std::cout << "    <" << std::setw(11) << (uint64_t{ 2 } << b) << " ns " << std::setw(10) << c << " "
+            << std::string(static_cast<size_t>(40 * c / n), '#') << "\n";
+    }
+}
+
+void PerfCounters::print() {
+    if constexpr (!ENABLED) {
+        std::cout << "Instrumentation was compiled out (CSOPESY_PERF=0).\n";
+        return;
+    }
+    static const char* names[OPCODES] = { "PRINT", "DECLARE", "ADD", "SUBTRACT", "SLEEP", "FOR", "READ", "WRITE" };
+
+    std::cout << "===== Execution Profile =====\n";
+    std::cout << "Instructions executed:\n  " << std::left << std::setw(8) << "core" << std::right;
+    for (const char* n : names) std::cout << std::setw(10) << n;
+    std::cout << "\n";
+    uint64_t count[OPCODES] = {}, ns[OPCODES] = {};
+    for (int s = 0; s <= MAX_CORES; ++s) {
+        uint64_t row = 0;
+        for (int t = 0; t < OPCODES; ++t) row += slots[s].count[t].load(std::memory_order_relaxed);
+        if (row == 0) continue;
+        std::cout << "  " << std::left << std::setw(8) << (s == MAX_CORES ? std::string("shell") : std::to_string(s))
+            << std::right;
+        for (int t = 0; t < OPCODES; ++t) {
+            uint64_t c = slots[s].count[t].load(std::memory_order_relaxed);
+            count[t] += c;
+            ns[t] += slots[s].ns[t].load(std::memory_order_relaxed);
+            std::cout << std::setw(10) << c;
+        }
+        std::cout << "\n";
+    }
+    std::cout << "  " << std::left << std::setw(8) << "total" << std::right;
+    for (uint64_t c : count) std::cout << std::setw(10) << c;
+    std::cout << "\n  " << std::left << std::setw(8) << "avg ns" << std::right;
+    for (int t = 0; t < OPCODES; ++t) std::cout << std::setw(10) << (count[t] ? ns[t] / count[t] : 0);
+    std::cout << "\n\n";
+
+    LatencyHistogram contextSwitch;
+    for (const OpCounters& s : slots) {
+        for (int b = 0; b < LatencyHistogram::BUCKETS; ++b) {
+            contextSwitch.buckets[b] += s.contextSwitch.buckets[b].load(std::memory_order_relaxed);
+        }
+        contextSwitch.count += s.contextSwitch.count.load(std::memory_order_relaxed);
+        contextSwitch.sum_ns += s.contextSwitch.sum_ns.load(std::memory_order_relaxed);
+        contextSwitch.max_ns = std::max(contextSwitch.max_ns.load(), s.contextSwitch.max_ns.load(std::memory_order_relaxed));
+    }
+    std::cout << "Latency (ns):\n  " << std::left << std::setw(16) << "" << std::right << std::setw(12) << "count"
+        << std::setw(10) << "avg" << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99"
+        << std::setw(12) << "max" << "\n";
+    printLatencyRow("dispatch", dispatch);
+    printLatencyRow("context switch", contextSwitch);
+    printLatencyRow("admission", admission);
+    printHistogramBars("dispatch", dispatch);
+    printHistogramBars("context switch", contextSwitch);
+    printHistogramBars("admission", admission);
+
+    uint64_t n = samples.load(std::memory_order_relaxed);
+    auto gaugeRow = [n](const std::string& what, const Gauge& g) {
+        std::cout << "  " << std::left << std::setw(16) << what << std::right
+            << std::setw(10) << g.last.load(std::memory_order_relaxed)
+            << std::setw(10) << std::fixed << std::setprecision(1)
+            << (n ? static_cast<double>(g.sum.load(std::memory_order_relaxed)) / n : 0.0) << std::defaultfloat
+            << std::setw(10) << g.max.load(std::memory_order_relaxed) << "\n";
+    };
+    std::cout << "\nQueue depth over " << n << " ticks:\n  " << std::left << std::setw(16) << "" << std::right
+        << std::setw(10) << "now" << std::setw(10) << "avg" << std::setw(10) << "max" << "\n";
+    gaugeRow("ready", ready);
+    gaugeRow("sleeping", sleeping);
+    gaugeRow("busy cores", busyCores);
+    std::cout << "  " << std::left << std::setw(16) << "generator" << std::right << std::setw(10)
+        << ProcessGenerator::getQueueDepth() << "  (of " << ProcessGenerator::getQueueCapacity() << ")\n";
+    std::cout << "=============================\n";
+}
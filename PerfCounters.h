@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Build with CSOPESY_PERF=0 to compile every probe below out of the hot path.
+#ifndef CSOPESY_PERF
+#define CSOPESY_PERF 1
+#endif
+
+// Log2 latency histogram: bucket i counts samples in [2^i, 2^(i+1)) ns.
+// Single writer; perf-stats reads it while it is written.
+struct LatencyHistogram {
+    static constexpr int BUCKETS = 40;
+
+    std::atomic<uint64_t> buckets[BUCKETS] = {};
+    std::atomic<uint64_t> count{ 0 };
+    std::atomic<uint64_t> sum_ns{ 0 };
+    std::atomic<uint64_t> max_ns{ 0 };
+
+    void record(uint64_t ns);
+    void reset();
+    uint64_t percentile(double p) const; // upper bound of the bucket holding it
+};
+
+// In-process profiling: how many instructions of each type every core ran and how
+// long they took, latency histograms for dispatch, context switch and admission, and
+// per-tick gauges of the scheduler's queues. Every counter has one writer (its core,
+// or the scheduler thread), so recording is a relaxed load and store; reset() runs on
+// the scheduler thread between ticks.
+class PerfCounters {
+public:
+    static constexpr bool ENABLED = CSOPESY_PERF != 0;
+    static constexpr int MAX_CORES = 128;
+    static constexpr int OPCODES = 8; // Instruction::Type
+
+    static void setCurrentCore(int core); // -1 = the shell (screen -s processes)
+
+    // Stamp to pass to the record calls; 0 and free when compiled out.
+    static uint64_t start() {
+        if constexpr (ENABLED) return nowNs();
+        else return 0;
+    }
+
+    static void countOp(int type, uint64_t since) {
+        if constexpr (ENABLED) {
+            OpCounters& c = slots[currentSlot];
+            bump(c.count[type], 1);
+            bump(c.ns[type], nowNs() - since);
+        }
+    }
+    static void recordSwitch(uint64_t since) { // core thread: first cycle of a newly assigned process
+        if constexpr (ENABLED) slots[currentSlot].contextSwitch.record(nowNs() - since);
+    }
+    static void recordDispatch(uint64_t since) { // scheduler thread
+        if constexpr (ENABLED) dispatch.record(nowNs() - since);
+    }
+    static void recordAdmission(uint64_t since) { // scheduler thread
+        if constexpr (ENABLED) admission.record(nowNs() - since);
+    }
+    static void sampleQueues(size_t ready, size_t sleeping, int busy) { // scheduler thread, once per tick
+        if constexpr (ENABLED) sample(ready, sleeping, busy);
+    }
+
+    static void print();
+    static void reset(); // scheduler thread, between ticks
+
+private:
+    struct alignas(64) OpCounters {
+        std::atomic<uint64_t> count[OPCODES] = {};
+        std::atomic<uint64_t> ns[OPCODES] = {};
+        LatencyHistogram contextSwitch;
+    };
+
+    struct Gauge {
+        std::atomic<uint64_t> last{ 0 };
+        std::atomic<uint64_t> max{ 0 };
+        std::atomic<uint64_t> sum{ 0 };
+
+        void sample(uint64_t v);
+        void reset();
+    };
+
+    static OpCounters slots[MAX_CORES + 1]; // the last one is the shell's
+    static thread_local int currentSlot;
+    static LatencyHistogram dispatch;
+    static LatencyHistogram admission;
+    static Gauge ready;
+    static Gauge sleeping;
+    static Gauge busyCores;
+    static std::atomic<uint64_t> samples;
+
+    static void sample(size_t readyCount, size_t sleepingCount, int busy);
+    static void bump(std::atomic<uint64_t>& c, uint64_t by) {
+        c.store(c.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+    static uint64_t nowNs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+};
@@ -4,11 +4,77 @@
 #include <chrono>
 #include <cctype>
 #include <limits>
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <exception>
+#include "Scheduler.h"
+#include "PerfCounters.h"
+
+namespace {
+    ObjectPool<Process>& processPool() {
+        static ObjectPool<Process> pool(256, "process blocks");
+        return pool;
+    }
+
+    constexpr size_t FRAME_BLOCK = 512;
+
+    FixedPool& framePool() {
+        static FixedPool pool(FRAME_BLOCK, 256, "task frames");
+        return pool;
+    }
+
+    Instruction::Type typeFromString(const std::string& s) {
+        if (s == "DECLARE") return Instruction::DECLARE;
+        if (s == "ADD") return Instruction::ADD;
+        if (s == "SUBTRACT") return Instruction::SUBTRACT;
+        if (s == "SLEEP") return Instruction::SLEEP;
+        if (s == "FOR") return Instruction::FOR;
+        if (s == "READ") return Instruction::READ;
+        if (s == "WRITE") return Instruction::WRITE;
+        return Instruction::PRINT;
+    }
+}
+
+void* ProcessTask::promise_type::operator new(size_t size) {
+    if (size <= FRAME_BLOCK) return framePool().allocate();
+    return ::operator new(size);
+}
+
+void ProcessTask::promise_type::operator delete(void* p, size_t size) {
+    if (size <= FRAME_BLOCK) framePool().deallocate(p);
+    else ::operator delete(p);
+}
 
-Process::Process(const std::string& name, const std::vector<Instruction>& ins)
-    : name(name), finished(false), instructions(ins), current_line(0) {
+Process::Process(const std::string& name, InstructionList ins, std::shared_ptr<Arena> arena)
+    : name(name), finished(false), echo_output(false), arena(std::move(arena)),
+    instructions(std::move(ins)), current_line(0), log_head(nullptr), log_tail(nullptr),
+    log_count(0), for_iter{}, for_level(-1), for_body_pending(false) {
+    publishSnapshot(0);
 }
 
+Process::~Process() {
+    while (log_head) {
+        LogRecord* next = log_head->next;
+        LogRecordPool::release(log_head);
+        log_head = next;
+    }
+    // instructions must go before the arena that backs them
+    instructions.clear();
+    instructions.shrink_to_fit();
+}
+
+Process* Process::create(const std::string& name, InstructionList instructions,
+    std::shared_ptr<Arena> arena) {
+    return processPool().create(name, std::move(instructions), std::move(arena));
+}
+
+void Process::destroy(Process* p) { processPool().destroy(p); }
+
+const AllocStats& Process::poolStats() { return processPool().getStats(); }
+
 std::string Process::getName() const { return name; }
 bool Process::isFinished() const { return finished; }
 void Process::setFinished(bool f) { finished = f; }
@@ -25,8 +91,138 @@ void Process::setVariable(const std::string& var, uint16_t value) {
     variables[var] = clampUint16(value);
 }
 
-const std::vector<std::string>& Process::getLogs() const { return logs; }
-void Process::addLog(const std::string& msg) { logs.push_back(msg); }
+ProcessTask& Process::getTask(bool logging) {
+    if (!task && !finished) task = logging ? run<true>() : run<false>();
+    return task;
+}
+
+void Process::setEchoOutput(bool echo) { echo_output = echo; }
+
+void Process::saveState(ProcessState& out) const {
+    out.current_line = current_line.load(std::memory_order_relaxed);
+    out.log_count = log_count.load(std::memory_order_relaxed);
+    out.finished = finished.load(std::memory_order_relaxed);
+    out.manual = echo_output;
+    out.for_level = for_level;
+    out.for_body_pending = for_body_pending;
+    std::copy(std::begin(for_iter), std::end(for_iter), out.for_iter);
+    out.variables.assign(variables.begin(), variables.end());
+    out.sched = sched;
+}
+
+// A fresh task picks up at current_line, and inside the FOR at for_level, which is
+// where the saved task was parked.
+void Process::loadState(const ProcessState& in) {
+    current_line = in.current_line;
+    finished = in.finished;
+    echo_output = in.manual;
+    for_level = in.for_level;
+    for_body_pending = in.for_body_pending;
+    std::copy(std::begin(in.for_iter), std::end(in.for_iter), for_iter);
+    variables.clear();
+    for (const auto& [var, value] : in.variables) variables.emplace_hint(variables.end(), var, value);
+    sched = in.sched;
+    sched.rq_next = nullptr;
+}
+
+std::vector<std::string> Process::getLogs() const {
+    return getLogs(log_count.load(std::memory_order_acquire));
+}
+
+std::vector<std::string> Process::getLogs(size_t count) const {
+    return getLogs(0, count);
+}
+
+std::vector<std::string> Process::getLogs(size_t from, size_t to) const {
+    // the list is append-only; every link before the published count is already written
+    to = std::min(to, log_count.load(std::memory_order_acquire));
+    std::vector<std::string> out;
+    if (from >= to) return out;
+    out.reserve(to - from);
+    const LogRecord* r = log_head;
+    for (size_t i = 0; i < to; ++i) {
+        std::string line;
+        for (; r->more; r = r->next) {
+            if (i >= from) line.append(r->view());
+        }
+        if (i >= from) {
+            line.append(r->view());
+            out.push_back(std::move(line));
+        }
+        if (i + 1 < to) r = r->next; // the last record's link may be being written
+    }
+    return out;
+}
+
+void Process::publishSnapshot(uint64_t tick) {
+    ProcessSnapshot snap{};
+    snap.current_line = current_line.load(std::memory_order_relaxed);
+    snap.total_lines = instructions.size();
+    snap.tick = tick;
+    snap.log_count = log_count.load(std::memory_order_relaxed);
+    snap.finished = finished.load(std::memory_order_relaxed);
+    snap.var_total = static_cast<uint32_t>(variables.size());
+    for (const auto& [var, value] : variables) {
+        if (snap.var_count == ProcessSnapshot::MAX_VARS) break;
+        ProcessSnapshot::Var& v = snap.vars[snap.var_count++];
+        size_t len = std::min<size_t>(var.size(), ProcessSnapshot::VAR_NAME_MAX);
+        std::memcpy(v.name, var.data(), len);
+        v.name[len] = '\0';
+        v.value = value;
+    }
+    published.store(snap);
+}
+
+ProcessSnapshot Process::snapshot() const {
+    return published.load();
+}
+
+void Process::appendLog(LogRecord* first, LogRecord* last) {
+    last->next = nullptr;
+    if (log_tail) log_tail->next = first;
+    else log_head = first;
+    log_tail = last;
+    log_count.store(log_count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void Process::addLog(std::string_view msg) {
+    // lines longer than one record are chained, never cut
+    LogRecord* first = LogRecordPool::acquire();
+    LogRecord* r = first;
+    while (true) {
+        r->len = static_cast<uint16_t>(std::min(msg.size(), LOG_TEXT_MAX));
+        std::memcpy(r->text, msg.data(), r->len);
+        msg.remove_prefix(r->len);
+        r->more = !msg.empty();
+        if (!r->more) break;
+        r->next = LogRecordPool::acquire();
+        r = r->next;
+    }
+    appendLog(first, r);
+}
+
+void Process::addLogf(const char* fmt, ...) {
+    // formatted straight into a record when it fits; otherwise once more, into the heap
+    LogRecord* r = LogRecordPool::acquire();
+    va_list ap, again;
+    va_start(ap, fmt);
+    va_copy(again, ap);
+    int n = std::vsnprintf(r->text, LOG_TEXT_MAX, fmt, ap);
+    va_end(ap);
+    if (n < 0) n = 0;
+    if (static_cast<size_t>(n) < LOG_TEXT_MAX) {
+        r->len = static_cast<uint16_t>(n);
+        r->more = false;
+        appendLog(r, r);
+    }
+    else {
+        LogRecordPool::release(r);
+        std::string line(static_cast<size_t>(n), '\0');
+        std::vsnprintf(line.data(), line.size() + 1, fmt, again);
+        addLog(line);
+    }
+    va_end(again);
+}
 
 bool Process::isNumber(const std::string& s) const {
     if (s.empty()) return false;
@@ -54,30 +250,168 @@ std::string Process::instrTypeAsString(Instruction::Type type) const {
     case Instruction::SUBTRACT: return "SUBTRACT";
     case Instruction::SLEEP: return "SLEEP";
     case Instruction::FOR: return "FOR";
+    case Instruction::READ: return "READ";
+    case Instruction::WRITE: return "WRITE";
     default: return "UNKNOWN";
     }
 }
 
-void Process::executeNextInstruction(int nestedLevel) {
-    if (finished || current_line >= instructions.size()) {
-        finished = true;
-        return;
-    }
+template <bool Logging>
+ProcessTask Process::run() {
+    bool owesCycle = false; // the previous instruction's tick has not been yielded yet
+
+    while (current_line < instructions.size()) {
+        if (owesCycle) {
+            owesCycle = false;
+            co_await ProcessTask::cycle();
+        }
+
+        const Instruction& instr = instructions[current_line];
+
+        uint64_t opStart = PerfCounters::start();
+        if (instr.type == Instruction::SLEEP) {
+            current_line++;
+            if (instr.args.empty()) continue;
+            uint8_t ticks = static_cast<uint8_t>(std::stoi(instr.args[0]));
+            if constexpr (Logging) addLogf("Sleeping for %u ticks...", static_cast<unsigned>(ticks));
+            PerfCounters::countOp(Instruction::SLEEP, opStart);
+            co_await ProcessTask::sleepFor(ticks);
+            continue;
+        }
+
+        if (instr.type == Instruction::READ || instr.type == Instruction::WRITE) {
+            // a page fault parks the task until the scheduler has paged in, then retries
+            while (!accessMemory(instr)) {
+                co_await ProcessTask::waitFor(MemoryManager::PAGE_FAULT_TICKS);
+                opStart = PerfCounters::start(); // the access that hits is the one timed
+            }
+            PerfCounters::countOp(instr.type, opStart);
+            current_line++;
+            owesCycle = true;
+            continue;
+        }
+
+        if (instr.type != Instruction::FOR) {
+            execute<Logging, false>(instr, 0);
+            PerfCounters::countOp(instr.type, opStart);
+            current_line++;
+            owesCycle = true;
+            continue;
+        }
+
+        // FOR <type> <repeats> <args...>; nested FORs are unrolled into an explicit
+        // counter stack so the task can suspend inside any level
+        PerfCounters::countOp(Instruction::FOR, opStart); // the body counts as its own type
+        int repeats[MAX_FOR_DEPTH];
+        int depth = 0;
+        size_t off = 0;
+        Instruction body;
+        bool bodyOk = false;
+        while (depth < MAX_FOR_DEPTH && instr.args.size() >= off + 2) {
+            repeats[depth++] = std::stoi(instr.args[off + 1]);
+            const std::string& innerType = instr.args[off];
+            if (innerType != "FOR") {
+                body.type = typeFromString(innerType);
+                body.args.assign(instr.args.begin() + off + 2, instr.args.end());
+                bodyOk = depth < MAX_FOR_DEPTH;
+                break;
+            }
+            off += 2;
+        }
+
+        bool overflow = !bodyOk && depth == MAX_FOR_DEPTH;
+        bool ranBody = false;
+        int level = depth > 0 ? 0 : -1;
+        bool resumeBody = false;
+        if (for_level >= 0) { // restored from a checkpoint taken inside this FOR
+            level = for_level;
+            resumeBody = for_body_pending;
+        }
+        else if (level == 0) {
+            for_iter[0] = 0;
+        }
+        while (level >= 0) {
+            if (resumeBody) {
+                resumeBody = false;
+            }
+            else {
+                if (for_iter[level] >= repeats[level]) { level--; continue; }
+                for_iter[level]++;
+                if constexpr (Logging) addLogf("[FOR LOOP] Iteration %d/%d", for_iter[level], repeats[level]);
+                if (level + 1 < depth) {
+                    level++;
+                    for_iter[level] = 0;
+                    continue;
+                }
+
+                if (!bodyOk && !overflow) continue; // malformed inner FOR is a no-op
+
+                if (owesCycle) {
+                    owesCycle = false;
+                    for_level = level;
+                    for_body_pending = true;
+                    co_await ProcessTask::cycle();
+                }
+            }
+            ranBody = true;
 
-    executeInstruction(instructions[current_line], nestedLevel);
-    current_line++;
+            uint64_t bodyStart = PerfCounters::start();
+            if (overflow) {
+                if constexpr (Logging) addLog("Error: FOR loop nesting exceeded 3 levels!");
+                owesCycle = true;
+            }
+            else if (body.type == Instruction::SLEEP) {
+                if (body.args.empty()) continue;
+                uint8_t ticks = static_cast<uint8_t>(std::stoi(body.args[0]));
+                if constexpr (Logging) addLogf("Sleeping for %u ticks...", static_cast<unsigned>(ticks));
+                for_level = level;
+                for_body_pending = false;
+                PerfCounters::countOp(Instruction::SLEEP, bodyStart);
+                co_await ProcessTask::sleepFor(ticks);
+            }
+            else if (body.type == Instruction::READ || body.type == Instruction::WRITE) {
+                for_level = level;
+                for_body_pending = true;
+                while (!accessMemory(body)) {
+                    co_await ProcessTask::waitFor(MemoryManager::PAGE_FAULT_TICKS);
+                    bodyStart = PerfCounters::start();
+                }
+                PerfCounters::countOp(body.type, bodyStart);
+                owesCycle = true;
+            }
+            else {
+                execute<Logging, false>(body, level + 1);
+                PerfCounters::countOp(body.type, bodyStart);
+                owesCycle = true;
+            }
+        }
+        for_level = -1;
+        current_line++;
+        if (!ranBody) owesCycle = true; // an empty FOR still takes its tick
+    }
 
-    if (current_line >= instructions.size()) finished = true;
+    finished = true;
 }
 
 void Process::executeInstruction(const Instruction& instr, int nestedLevel) {
+    uint64_t opStart = PerfCounters::start();
+    if (echo_output) execute<true, true>(instr, nestedLevel);
+    else execute<true, false>(instr, nestedLevel);
+    PerfCounters::countOp(instr.type, opStart);
+}
+
+// Logging and Echo are fixed per instantiation: the scheduled path runs <logging, false>,
+// the shell runs <true, echo>.
+template <bool Logging, bool Echo>
+void Process::execute(const Instruction& instr, int nestedLevel) {
     if (nestedLevel > 3) {
-        addLog("Error: FOR loop nesting exceeded 3 levels!");
+        if constexpr (Logging) addLog("Error: FOR loop nesting exceeded 3 levels!");
         return;
     }
 
     switch (instr.type) {
     case Instruction::PRINT: {
+        if constexpr (!Logging && !Echo) break; // nobody would see the line
         std::string out;
 
         if (instr.args.empty()) {
@@ -104,8 +438,8 @@ void Process::executeInstruction(const Instruction& instr, int nestedLevel) {
             }
         }
 
-        addLog(out);
-        std::cout << "[" << name << "] " << out << std::endl;
+        if constexpr (Logging) addLog(out);
+        if constexpr (Echo) std::cout << "[" << name << "] " << out << std::endl;
         break;
     }
 
@@ -171,7 +505,7 @@ void Process::executeInstruction(const Instruction& instr, int nestedLevel) {
     case Instruction::SLEEP: {
         if (instr.args.empty()) break;
         uint8_t ticks = static_cast<uint8_t>(std::stoi(instr.args[0]));
-        addLog("Sleeping for " + std::to_string(ticks) + " ticks...");
+        if constexpr (Logging) addLogf("Sleeping for %u ticks...", static_cast<unsigned>(ticks));
         std::this_thread::sleep_for(std::chrono::milliseconds(ticks * 100));
         break;
     }
@@ -181,9 +515,8 @@ void Process::executeInstruction(const Instruction& instr, int nestedLevel) {
 
         std::string innerTypeStr = instr.args[0];
         int repeats = std::stoi(instr.args[1]);
-        std::vector<std::string> innerArgs(instr.args.begin() + 2, instr.args.end());
-
         Instruction innerInstr;
+        innerInstr.args.assign(instr.args.begin() + 2, instr.args.end());
 
         // map string to type
         if (innerTypeStr == "PRINT") innerInstr.type = Instruction::PRINT;
@@ -192,17 +525,55 @@ void Process::executeInstruction(const Instruction& instr, int nestedLevel) {
         else if (innerTypeStr == "SUBTRACT") innerInstr.type = Instruction::SUBTRACT;
         else if (innerTypeStr == "SLEEP") innerInstr.type = Instruction::SLEEP;
         else if (innerTypeStr == "FOR") innerInstr.type = Instruction::FOR;
-        innerInstr.args = innerArgs;
 
         for (int i = 0; i < repeats; ++i) {
-            addLog("[FOR LOOP] Iteration " + std::to_string(i + 1) + "/" + std::to_string(repeats));
-            executeInstruction(innerInstr, nestedLevel + 1);
+            if constexpr (Logging) addLogf("[FOR LOOP] Iteration %d/%d", i + 1, repeats);
+            execute<Logging, Echo>(innerInstr, nestedLevel + 1);
+        }
+        break;
+    }
+
+    case Instruction::READ:
+    case Instruction::WRITE: {
+        // outside a tick the mapping may change under us; do it on the scheduler thread
+        try {
+            Scheduler::call([&] {
+                while (!accessMemory(instr)) {
+                    // forced, RETRY means there is no frame at all: waiting would not help
+                    FaultResult r = MemoryManager::serviceFault(memory, true);
+                    if (r == FaultResult::RETRY) {
+                        throw std::runtime_error("Page fault could not be serviced; there is no physical memory");
+                    }
+                    if (r == FaultResult::FAILED) {
+                        throw std::runtime_error("Page fault could not be serviced; the backing store cannot grow");
+                    }
+                }
+            });
+        }
+        catch (const std::exception& e) {
+            if constexpr (Logging) addLog(std::string("Error: ") + e.what());
+            if constexpr (Echo) std::cout << "[" << name << "] Error: " << e.what() << std::endl;
         }
         break;
     }
 
     default:
-        addLog("Unknown instruction type!");
+        if constexpr (Logging) addLog("Unknown instruction type!");
         break;
     }
 }
+
+// READ <var> <address> and WRITE <address> <value>; addresses may be hex (0x...).
+bool Process::accessMemory(const Instruction& instr) {
+    if (instr.args.size() < 2) return true;
+    if (instr.type == Instruction::READ) {
+        uint16_t value;
+        if (!MemoryManager::tryRead(memory, static_cast<uint32_t>(std::stoul(instr.args[1], nullptr, 0)), value)) {
+            return false;
+        }
+        setVariable(instr.args[0], value);
+        return true;
+    }
+    uint16_t value = getValue(instr.args[1]);
+    return MemoryManager::tryWrite(memory, static_cast<uint32_t>(std::stoul(instr.args[0], nullptr, 0)), value);
+}
@@ -2,16 +2,80 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <atomic>
+#include <string_view>
+#include <utility>
+#include "MemoryPool.h"
+#include "ProcessTask.h"
+#include "Seqlock.h"
+#include "MemoryManager.h"
+
+using ArgList = std::vector<std::string, ArenaAllocator<std::string>>;
 
 struct Instruction {
-    enum Type { PRINT, DECLARE, ADD, SUBTRACT, SLEEP, FOR };
+    enum Type { PRINT, DECLARE, ADD, SUBTRACT, SLEEP, FOR, READ, WRITE };
     Type type = Type::PRINT;
-    std::vector<std::string> args;
+    ArgList args;
+};
+
+// What process-smi and screen -ls see of a process: one consistent cut of its
+// execution state, published by whichever thread runs it.
+struct ProcessSnapshot {
+    static constexpr int MAX_VARS = 8;
+    static constexpr int VAR_NAME_MAX = 13;
+
+    struct Var {
+        char name[VAR_NAME_MAX + 1];
+        uint16_t value;
+    };
+
+    uint64_t current_line;
+    uint64_t total_lines;
+    uint64_t tick;        // scheduler tick of the last publish
+    uint64_t log_count;   // logs that belong to this cut
+    uint32_t var_count;   // variables shown (the first MAX_VARS by name)
+    uint32_t var_total;
+    bool finished;
+    Var vars[MAX_VARS];
 };
 
+class Process;
+struct ProcessState;
+
+// Scheduler bookkeeping for a process. Only the scheduler thread touches it; pid is
+// set before admission and never changes, so a core may read it.
+struct SchedInfo {
+    static constexpr int PRIORITY_LEVELS = 32;
+
+    uint32_t pid = 0;                   // the number in a generated process's name; 0 otherwise
+    int priority = PRIORITY_LEVELS / 2; // 0 runs first
+    int level = 0;                      // MLFQ queue
+    uint64_t boost_epoch = 0;           // MLFQ boost period the level belongs to
+    uint64_t seq = 0;                   // enqueue order, breaks ties first-come first-served
+    uint64_t arrival_tick = 0;
+    uint64_t ready_since = 0;
+    uint64_t waiting_ticks = 0;         // total time spent runnable but not on a core
+    int last_core = -1;                 // core it last ran on; its run queue is tried first
+    Process* rq_next = nullptr;         // link within a RunQueue level
+};
+
+// Generated processes keep their instruction stream in the arena of the batch they came from.
+using InstructionList = std::vector<Instruction, ArenaAllocator<Instruction>>;
+
 class Process {
 public:
-    Process(const std::string& name, const std::vector<Instruction>& instructions);
+    Process(const std::string& name, InstructionList instructions,
+        std::shared_ptr<Arena> arena = nullptr);
+    ~Process();
+    Process(const Process&) = delete;
+    Process& operator=(const Process&) = delete;
+
+    // Process control blocks live in a fixed-size pool; use these instead of new/delete.
+    static Process* create(const std::string& name, InstructionList instructions,
+        std::shared_ptr<Arena> arena = nullptr);
+    static void destroy(Process* p);
+    static const AllocStats& poolStats();
 
     std::string getName() const;
     bool isFinished() const;
@@ -20,22 +84,64 @@ public:
     size_t getCurrentLine() const;
     size_t getTotalLines() const;
 
+    // Coroutine that runs the whole instruction stream, created on first dispatch.
+    // logging picks the instantiation it is created with.
+    ProcessTask& getTask(bool logging = true);
+    SchedInfo& getSchedInfo() { return sched; }
+    AddressSpace& getMemory() { return memory; }
+    const SchedInfo& getSchedInfo() const { return sched; }
+
+    // Echo PRINT output to the console (screen -s processes only; cores run silently).
+    void setEchoOutput(bool echo);
+
     uint16_t getVariable(const std::string& name) const;
     void setVariable(const std::string& name, uint16_t value);
 
-    const std::vector<std::string>& getLogs() const;
-    void addLog(const std::string& msg);
+    std::vector<std::string> getLogs() const;
+    std::vector<std::string> getLogs(size_t count) const; // the first count lines
+    std::vector<std::string> getLogs(size_t from, size_t to) const; // lines [from, to)
 
-    void executeNextInstruction(int nestedLevel = 0); // execute current instruction
+    // Writer side: called by the thread that just ran the process (one at a time).
+    void publishSnapshot(uint64_t tick);
+    // Reader side: never blocks the writer and never touches execution state.
+    ProcessSnapshot snapshot() const;
+    void addLog(std::string_view msg);
+    void addLogf(const char* fmt, ...); // formats straight into a pooled log record
+
+    // Runs one instruction synchronously on the calling thread (manual screen input).
     void executeInstruction(const Instruction& instr, int nestedLevel = 0);
 
+    static constexpr int MAX_FOR_DEPTH = 4; // 3 nested levels plus the one that reports the overflow
+
+    // Checkpoint support. saveState needs the process parked (between ticks, or a
+    // screen -s process on the shell thread); loadState is for a process that has not run.
+    void saveState(ProcessState& out) const;
+    void loadState(const ProcessState& in);
+    const InstructionList& getInstructions() const { return instructions; }
+
 private:
     std::string name;
-    bool finished;
-    std::vector<Instruction> instructions;
-    size_t current_line;
+    std::atomic<bool> finished;
+    bool echo_output;
+    std::shared_ptr<Arena> arena; // keeps the batch arena alive while we use it
+    InstructionList instructions;
+    std::atomic<size_t> current_line;
     std::map<std::string, uint16_t> variables;
-    std::vector<std::string> logs;
+    LogRecord* log_head;
+    LogRecord* log_tail;
+    std::atomic<size_t> log_count; // readers only walk this many lines
+    int for_iter[MAX_FOR_DEPTH];   // iteration counters of the FOR being executed
+    int for_level;                 // level the task last suspended at inside a FOR, -1 outside
+    bool for_body_pending;         // ...with that iteration's body still to run
+    Seqlock<ProcessSnapshot> published;
+    ProcessTask task;
+    SchedInfo sched;
+    AddressSpace memory;
+
+    template <bool Logging> ProcessTask run();
+    template <bool Logging, bool Echo> void execute(const Instruction& instr, int nestedLevel);
+    bool accessMemory(const Instruction& instr); // READ/WRITE; false on a page fault
+    void appendLog(LogRecord* first, LogRecord* last); // one line
 
     // helpers
     bool isNumber(const std::string& s) const;
@@ -44,3 +150,17 @@ private:
 
     std::string instrTypeAsString(Instruction::Type type) const;
 };
+
+// Execution state of a process as a checkpoint saves it. The name, instructions and
+// logs never change once written, so they are read from the process directly.
+struct ProcessState {
+    uint64_t current_line = 0;
+    uint64_t log_count = 0;
+    bool finished = false;
+    bool manual = false; // screen -s process, never scheduled
+    int for_level = -1;
+    bool for_body_pending = false;
+    int for_iter[Process::MAX_FOR_DEPTH] = {};
+    std::vector<std::pair<std::string, uint16_t>> variables;
+    SchedInfo sched;
+};
@@ -0,0 +1,162 @@
+#include "ProcessGenerator.h"
+#include <bit>
+#include <cstdio>
+#include "Config.h"
+#include "MemoryManager.h"
+
+std::thread ProcessGenerator::producer;
+std::mutex ProcessGenerator::mtx;
+std::condition_variable ProcessGenerator::notFull;
+std::condition_variable ProcessGenerator::notEmpty;
+std::deque<ProcessGenerator::Built> ProcessGenerator::queue;
+size_t ProcessGenerator::capacity = 64;
+bool ProcessGenerator::stopping = false;
+std::mt19937 ProcessGenerator::rng;
+unsigned int ProcessGenerator::seed = 0;
+std::atomic<uint64_t> ProcessGenerator::taken{ 0 };
+std::atomic<uint64_t> ProcessGenerator::produced{ 0 };
+std::atomic<uint64_t> ProcessGenerator::stalls{ 0 };
+
+void ProcessGenerator::start(unsigned int newSeed) {
+    stop();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        queue.clear(); // streams built for the old config are stale
+        capacity = static_cast<size_t>(Config::getGenQueueDepth());
+        stopping = false;
+    }
+    seed = newSeed;
+    taken = 0;
+    rng.seed(seed);
+    producer = std::thread(&ProcessGenerator::producerLoop);
+}
+
+void ProcessGenerator::stop() {
+    if (!producer.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    notFull.notify_all();
+    notEmpty.notify_all();
+    producer.join();
+}
+
+Process* ProcessGenerator::next(const std::string& name) {
+    Built built;
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        notEmpty.wait(lock, [] { return !queue.empty() || stopping; });
+        if (queue.empty()) return nullptr;
+        built = std::move(queue.front());
+        queue.pop_front();
+    }
+    taken.fetch_add(1, std::memory_order_relaxed);
+    notFull.notify_one();
+    Process* p = Process::create(name, std::move(built.instructions), std::move(built.arena));
+    p->getSchedInfo().priority = built.priority;
+    MemoryManager::attach(p->getMemory(), built.memBytes);
+    return p;
+}
+
+size_t ProcessGenerator::getQueueDepth() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return queue.size();
+}
+
+size_t ProcessGenerator::getQueueCapacity() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return capacity;
+}
+
+uint64_t ProcessGenerator::getProduced() { return produced.load(std::memory_order_relaxed); }
+uint64_t ProcessGenerator::getProducerStalls() { return stalls.load(std::memory_order_relaxed); }
+unsigned int ProcessGenerator::getSeed() { return seed; }
+uint64_t ProcessGenerator::getTaken() { return taken.load(std::memory_order_relaxed); }
+
+void ProcessGenerator::producerLoop() {
+    std::shared_ptr<Arena> arena;
+    int inArena = 0;
+
+    while (true) {
+        // build outside the lock; only the hand-off is serialized
+        if (!arena || inArena == PROCESSES_PER_ARENA) {
+            arena = std::make_shared<Arena>();
+            inArena = 0;
+        }
+        std::uniform_int_distribution<> dis(Config::getMinIns(), Config::getMaxIns());
+        std::uniform_int_distribution<> prio(0, SchedInfo::PRIORITY_LEVELS - 1);
+        int count = dis(rng);
+        int priority = prio(rng);
+        uint32_t memBytes = drawMemSize();
+        Built built{ arena, generateInstructions(count, memBytes, arena.get()), priority, memBytes };
+        inArena++;
+
+        std::unique_lock<std::mutex> lock(mtx);
+        if (queue.size() >= capacity) {
+            stalls.fetch_add(1, std::memory_order_relaxed);
+            notFull.wait(lock, [] { return queue.size() < capacity || stopping; });
+        }
+        if (stopping) return;
+        queue.push_back(std::move(built));
+        produced.fetch_add(1, std::memory_order_relaxed);
+        lock.unlock();
+        notEmpty.notify_one();
+    }
+}
+
+uint32_t ProcessGenerator::drawMemSize() {
+    std::uniform_int_distribution<> exp(std::countr_zero(static_cast<uint32_t>(Config::getMinMemPerProc())),
+        std::countr_zero(static_cast<uint32_t>(Config::getMaxMemPerProc())));
+    return 1u << exp(rng);
+}
+
+InstructionList ProcessGenerator::generateInstructions(int count, uint32_t memBytes, Arena* arena) {
+    InstructionList ins{ ArenaAllocator<Instruction>(arena) };
+    ins.reserve(count);
+    ArenaAllocator<std::string> argAlloc(arena);
+    std::uniform_int_distribution<> opDist(0, 7);
+    std::uniform_int_distribution<uint32_t> addrDist(0, memBytes / 2 - 1); // even, in bounds
+    char addr[16];
+
+    for (int i = 0; i < count; ++i) {
+        Instruction instr;
+        int op = opDist(rng);
+        if (op == 0) {
+            instr.type = Instruction::PRINT;
+            instr.args = ArgList({ "\"Hello world from <name>!\"" }, argAlloc);
+        }
+        else if (op == 1) {
+            instr.type = Instruction::DECLARE;
+            instr.args = ArgList({ "x", "0" }, argAlloc);
+        }
+        else if (op == 2) {
+            instr.type = Instruction::ADD;
+            instr.args = ArgList({ "x", "5", "10" }, argAlloc);
+        }
+        else if (op == 3) {
+            instr.type = Instruction::SUBTRACT;
+            instr.args = ArgList({ "x", "x", "1" }, argAlloc);
+        }
+        else if (op == 4) {
+            instr.type = Instruction::SLEEP;
+            instr.args = ArgList({ "2" }, argAlloc);
+        }
+        else if (op == 5) {
+            instr.type = Instruction::FOR;
+            instr.args = ArgList({ "2" }, argAlloc);
+        }
+        else if (op == 6) {
+            std::snprintf(addr, sizeof(addr), "0x%X", addrDist(rng) * 2);
+            instr.type = Instruction::WRITE;
+            instr.args = ArgList({ addr, "x" }, argAlloc);
+        }
+        else {
+            std::snprintf(addr, sizeof(addr), "0x%X", addrDist(rng) * 2);
+            instr.type = Instruction::READ;
+            instr.args = ArgList({ "x", addr }, argAlloc);
+        }
+        ins.push_back(std::move(instr));
+    }
+    return ins;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include "Process.h"
+
+// Producer stage for dummy processes. A background thread builds instruction streams
+// ahead of time into a bounded queue, so the thread that admits a process only pops
+// one and names it. The producer blocks while the queue is full.
+class ProcessGenerator {
+public:
+    static void start(unsigned int seed); // (re)starts the producer with the current config
+    static void stop();
+
+    // Pops the next prebuilt stream and turns it into a named Process.
+    // Blocks while the producer is behind; returns nullptr once stopped.
+    static Process* next(const std::string& name);
+
+    static size_t getQueueDepth();
+    static size_t getQueueCapacity();
+    static uint64_t getProduced();
+    static uint64_t getProducerStalls(); // times the producer found the queue full
+    static unsigned int getSeed();
+    static uint64_t getTaken(); // streams handed out since start(); the next one is this index
+
+private:
+    struct Built {
+        std::shared_ptr<Arena> arena; // declared first so it outlives the instructions in it
+        InstructionList instructions;
+        int priority;
+        uint32_t memBytes;
+    };
+
+    static constexpr int PROCESSES_PER_ARENA = 16;
+
+    static std::thread producer;
+    static std::mutex mtx;
+    static std::condition_variable notFull;
+    static std::condition_variable notEmpty;
+    static std::deque<Built> queue;
+    static size_t capacity;
+    static bool stopping;
+    static std::mt19937 rng; // producer thread only
+    static unsigned int seed;
+    static std::atomic<uint64_t> taken;
+    static std::atomic<uint64_t> produced;
+    static std::atomic<uint64_t> stalls;
+
+    static void producerLoop();
+    static uint32_t drawMemSize(); // power of two in [min-mem-per-proc, max-mem-per-proc]
+    static InstructionList generateInstructions(int count, uint32_t memBytes, Arena* arena);
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <utility>
+
+// Why a process task gave the core back.
+enum class YieldReason { NONE, CYCLE, QUANTUM, SLEEP, WAIT, FINISHED };
+
+// Resumable execution of one process. Each resume() runs exactly one instruction
+// and suspends at the next tick boundary, so a process can be parked mid-FOR or
+// mid-SLEEP without holding a thread.
+class ProcessTask {
+public:
+    struct promise_type {
+        YieldReason reason = YieldReason::NONE;
+        int64_t budget = -1;      // instructions left in the quantum, -1 = unlimited
+        uint64_t waitTicks = 0;   // for SLEEP / WAIT
+        std::exception_ptr error;
+
+        ProcessTask get_return_object() {
+            return ProcessTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept {
+            reason = YieldReason::FINISHED;
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() { error = std::current_exception(); }
+
+        // frames are small and created at every first dispatch; keep them off the global heap
+        static void* operator new(size_t size);
+        static void operator delete(void* p, size_t size);
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    // End of an instruction: costs one tick, and gives up the core when the quantum is spent.
+    struct CycleAwaiter {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(Handle h) const noexcept {
+            promise_type& p = h.promise();
+            if (p.budget > 0 && --p.budget == 0) p.reason = YieldReason::QUANTUM;
+            else p.reason = YieldReason::CYCLE;
+        }
+        void await_resume() const noexcept {}
+    };
+
+    // Leave the core for a number of ticks (SLEEP), or stall on it while the scheduler
+    // services a page fault (WAIT).
+    struct BlockAwaiter {
+        YieldReason reason;
+        uint64_t ticks;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(Handle h) const noexcept {
+            h.promise().reason = reason;
+            h.promise().waitTicks = ticks;
+        }
+        void await_resume() const noexcept {}
+    };
+
+    static CycleAwaiter cycle() { return {}; }
+    static BlockAwaiter sleepFor(uint64_t ticks) { return { YieldReason::SLEEP, ticks }; }
+    static BlockAwaiter waitFor(uint64_t ticks) { return { YieldReason::WAIT, ticks }; }
+
+    ProcessTask() = default;
+    explicit ProcessTask(Handle h) : handle(h) {}
+    ProcessTask(ProcessTask&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    ProcessTask& operator=(ProcessTask&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, {});
+        }
+        return *this;
+    }
+    ProcessTask(const ProcessTask&) = delete;
+    ProcessTask& operator=(const ProcessTask&) = delete;
+    ~ProcessTask() { if (handle) handle.destroy(); }
+
+    explicit operator bool() const { return static_cast<bool>(handle); }
+    bool done() const { return !handle || handle.done(); }
+
+    // Runs the task up to its next suspension point and reports why it stopped.
+    YieldReason resume() {
+        if (done()) return YieldReason::FINISHED;
+        handle.promise().reason = YieldReason::NONE;
+        handle.resume();
+        if (handle.promise().error) std::rethrow_exception(std::exchange(handle.promise().error, nullptr));
+        return handle.promise().reason;
+    }
+
+    void setBudget(int64_t instructions) { if (handle) handle.promise().budget = instructions; }
+    int64_t getBudget() const { return handle ? handle.promise().budget : -1; }
+    uint64_t getWaitTicks() const { return handle ? handle.promise().waitTicks : 0; }
+
+private:
+    Handle handle;
+};
@@ -0,0 +1,147 @@
+#include "ReportUtil.h"
+#include <algorithm>
+#include <charconv>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include "Config.h"
+#include "ProcessGenerator.h"
+#include "Scheduler.h"
+
+void ReportWriter::put(std::string& s, uint64_t v) {
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), v);
+    s.append(buf, res.ptr);
+}
+
+void ReportWriter::putFixed(std::string& s, double v) {
+    char buf[48];
+    auto res = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::fixed, 2);
+    s.append(buf, res.ptr);
+}
+
+void ReportWriter::putRow(std::string& s, const std::string& name, size_t id, uint64_t line, uint64_t total) {
+    put(s, "  ");
+    put(s, name);
+    put(s, " (ID ");
+    put(s, static_cast<uint64_t>(id));
+    put(s, ") - Line ");
+    put(s, line);
+    put(s, " / ");
+    put(s, total);
+    s += '\n';
+}
+
+void ReportWriter::putTimestamp() {
+    std::time_t now = std::time(nullptr);
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    char buf[32];
+    size_t n = std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &local);
+    out.append(buf, n);
+}
+
+void ReportWriter::collect(const std::vector<Process*>& processes, uint64_t gen) {
+    out.clear();
+    finishedRows.clear();
+    changed = 0;
+    bool full = gen != generation || rows.size() > processes.size();
+    if (full) {
+        rows.clear(); // a restore or replay replaced the list; start over
+        generation = gen;
+    }
+
+    int totalCores = Config::getNumCpu();
+    int usedCores = std::min(Scheduler::getBusyCores(), totalCores);
+    double utilization = (totalCores > 0) ? (100.0 * usedCores / totalCores) : 0.0;
+
+    put(out, "===== CPU Utilization Report #");
+    put(out, ++reports);
+    put(out, " at ");
+    putTimestamp();
+    put(out, full ? " (full) =====\n" : " (changes) =====\n");
+    put(out, "Cores used: ");
+    put(out, static_cast<uint64_t>(usedCores));
+    put(out, " / ");
+    put(out, static_cast<uint64_t>(totalCores));
+    put(out, "\nCPU Utilization: ");
+    putFixed(out, utilization);
+    put(out, "%\nCurrent tick: ");
+    put(out, Scheduler::getCurrentTick());
+    put(out, "\n\nRunning Processes:\n");
+    size_t headerEnd = out.size();
+
+    // one pass: finished rows already in the log need no snapshot at all
+    size_t running = 0;
+    size_t finished = 0;
+    size_t known = rows.size();
+    rows.resize(processes.size());
+    for (size_t i = 0; i < processes.size(); ++i) {
+        Row& row = rows[i];
+        if (row.finished) {
+            finished++;
+            continue;
+        }
+        ProcessSnapshot snap = processes[i]->snapshot();
+        if (snap.finished) finished++;
+        else running++;
+        if (i < known && snap.current_line == row.line && !snap.finished) continue;
+        row.line = snap.current_line;
+        row.finished = snap.finished;
+        putRow(snap.finished ? finishedRows : out, processes[i]->getName(), i + 1, snap.current_line, snap.total_lines);
+        changed++;
+    }
+    if (out.size() == headerEnd) put(out, "  None changed\n");
+    put(out, "\nFinished Processes:\n");
+    if (finishedRows.empty()) put(out, "  None new\n");
+    else out += finishedRows;
+
+    put(out, "\nProcesses: ");
+    put(out, static_cast<uint64_t>(running));
+    put(out, " running, ");
+    put(out, static_cast<uint64_t>(finished));
+    put(out, " finished, ");
+    put(out, static_cast<uint64_t>(changed));
+    put(out, " rows in this report\nLive processes: ");
+    put(out, static_cast<uint64_t>(Scheduler::getLiveProcesses()));
+    if (Config::getMaxLiveProcesses() > 0) {
+        put(out, " / ");
+        put(out, static_cast<uint64_t>(Config::getMaxLiveProcesses()));
+    }
+    put(out, " (");
+    put(out, Scheduler::getPausedArrivals());
+    put(out, " arrivals paused)\nGenerator queue: ");
+    put(out, static_cast<uint64_t>(ProcessGenerator::getQueueDepth()));
+    put(out, " / ");
+    put(out, static_cast<uint64_t>(ProcessGenerator::getQueueCapacity()));
+    put(out, " (");
+    put(out, ProcessGenerator::getProducerStalls());
+    put(out, " producer stalls)\nPolicy ");
+    put(out, Config::getScheduler());
+    put(out, ": ");
+    put(out, Scheduler::getFinishedCount());
+    put(out, " finished, avg waiting ");
+    putFixed(out, Scheduler::getAvgWaitingTicks());
+    put(out, " ticks, avg turnaround ");
+    putFixed(out, Scheduler::getAvgTurnaroundTicks());
+    put(out, " ticks\n==================================\n\n");
+}
+
+bool ReportWriter::flush() {
+    std::ofstream file(path, std::ios::app | std::ios::binary);
+    if (!file.is_open()) {
+        std::cout << "Error: Cannot open " << path << " for writing.\n";
+        return false;
+    }
+    file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    file.close();
+    if (!file) {
+        std::cout << "Error: Cannot write " << path << ".\n";
+        return false;
+    }
+    return true;
+}
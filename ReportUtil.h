@@ -1 +1,43 @@
 #pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Process.h"
+
+// Appends timestamped utilization reports to a log file. A report lists only the
+// processes whose line or state changed since the previous one, and a finished
+// process only once, so its cost follows the activity rather than the number of
+// processes ever created. Rows are formatted with std::to_chars into one buffer and
+// written with a single call.
+class ReportWriter {
+public:
+    explicit ReportWriter(std::string path) : path(std::move(path)) {}
+
+    // Under the process-list lock; generation changes whenever the list is replaced.
+    void collect(const std::vector<Process*>& processes, uint64_t generation);
+    bool flush(); // appends the collected report; false if the file cannot be written
+
+    const std::string& getPath() const { return path; }
+    size_t getChangedRows() const { return changed; } // in the last collected report
+
+private:
+    struct Row {
+        uint64_t line = 0;
+        bool finished = false;
+    };
+
+    std::string path;
+    std::vector<Row> rows; // what the log last said about each process, by list position
+    uint64_t generation = UINT64_MAX;
+    uint64_t reports = 0;
+    size_t changed = 0;
+    std::string out;
+    std::string finishedRows; // the finished section, built in the same pass
+
+    static void put(std::string& s, std::string_view v) { s.append(v); }
+    static void put(std::string& s, uint64_t v);
+    static void putFixed(std::string& s, double v); // two decimals
+    static void putRow(std::string& s, const std::string& name, size_t id, uint64_t line, uint64_t total);
+    void putTimestamp();
+};
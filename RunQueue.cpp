@@ -0,0 +1,54 @@
+#include "RunQueue.h"
+#include <bit>
+
+void RunQueue::push(Process* p, int level) {
+    Fifo& f = fifos[level];
+    p->getSchedInfo().rq_next = nullptr;
+    if (f.tail) f.tail->getSchedInfo().rq_next = p;
+    else f.head = p;
+    f.tail = p;
+    bitmap |= bitFor(level);
+    count++;
+}
+
+int RunQueue::bestLevel() const {
+    return bitmap ? std::countl_zero(bitmap) : -1;
+}
+
+Process* RunQueue::pop() {
+    int level = bestLevel();
+    return level < 0 ? nullptr : popLevel(level);
+}
+
+Process* RunQueue::popLevel(int level) {
+    Fifo& f = fifos[level];
+    Process* p = f.head;
+    if (!p) return nullptr;
+    f.head = p->getSchedInfo().rq_next;
+    p->getSchedInfo().rq_next = nullptr;
+    if (!f.head) {
+        f.tail = nullptr;
+        bitmap &= ~bitFor(level);
+    }
+    count--;
+    return p;
+}
+
+void RunQueue::mergeInto(int level) {
+    Fifo merged;
+    for (uint64_t bits = bitmap; bits; ) {
+        int l = std::countl_zero(bits);
+        bits &= ~bitFor(l);
+        Fifo& f = fifos[l];
+        if (merged.tail) merged.tail->getSchedInfo().rq_next = f.head;
+        else merged.head = f.head;
+        merged.tail = f.tail;
+        f = Fifo{};
+    }
+    fifos[level] = merged;
+    bitmap = merged.head ? bitFor(level) : 0;
+}
+
+void RunQueue::drain(std::vector<Process*>& out) {
+    while (Process* p = pop()) out.push_back(p);
+}
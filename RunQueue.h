@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Process.h"
+
+// Constant-time run queue: one FIFO per priority level, linked through the processes
+// themselves, plus an occupancy bitmap. The best non-empty level is a single
+// count-leading-zeros, so push and pop cost the same with 10 or 100000 processes.
+class RunQueue {
+public:
+    static constexpr int LEVELS = 64; // one bit of the bitmap each; 0 is the best
+
+    static uint64_t bitFor(int level) { return uint64_t(1) << (63 - level); }
+
+    void push(Process* p, int level); // to the tail of level
+    Process* pop();                   // head of the best level, nullptr when empty
+    Process* popLevel(int level);
+    Process* head(int level) const { return fifos[level].head; }
+
+    int bestLevel() const;                          // -1 when empty
+    uint64_t occupancy() const { return bitmap; }   // bit 63 - level is set while level is non-empty
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    void mergeInto(int level); // moves every process to the tail of level, keeping level order
+    void drain(std::vector<Process*>& out); // best level first, FIFO within a level
+
+    // Visits f(process, level) in drain order without changing the queue.
+    template <class F> void forEach(F f) const {
+        for (int l = 0; l < LEVELS; ++l) {
+            for (Process* p = fifos[l].head; p; p = p->getSchedInfo().rq_next) f(p, l);
+        }
+    }
+
+private:
+    struct Fifo {
+        Process* head = nullptr;
+        Process* tail = nullptr;
+    };
+
+    Fifo fifos[LEVELS];
+    uint64_t bitmap = 0;
+    size_t count = 0;
+};
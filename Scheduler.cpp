@@ -2,27 +2,356 @@
 #include <iostream>
 #include "Config.h"
 #include "ScreenManager.h" // add process to global list
+#include "ProcessGenerator.h"
+#include "MemoryManager.h"
+#include "PerfCounters.h"
+#include "Topology.h"
 #include <random>
 #include <string>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <exception>
+#include <future>
 
-int Scheduler::nextProcessId = 1;
-bool Scheduler::running = false;
+std::atomic<int> Scheduler::nextProcessId{ 1 };
+std::atomic<bool> Scheduler::running{ false };
 int Scheduler::tickCounter = 0;
 int Scheduler::tickInterval = 1; // will be set from config later
 
-void Scheduler::initialize() {
-    nextProcessId = 1;
+std::atomic<bool> Scheduler::alive{ false };
+std::atomic<uint64_t> Scheduler::currentTick{ 0 };
+std::atomic<int> Scheduler::busyCores{ 0 };
+std::thread Scheduler::driver;
+TickSync Scheduler::tickSync;
+std::vector<std::unique_ptr<CpuCore>> Scheduler::cores;
+std::shared_mutex Scheduler::coresMutex;
+std::vector<int> Scheduler::placement;
+std::unique_ptr<SchedulingPolicy> Scheduler::policy;
+ExecProfile Scheduler::profile;
+void (*Scheduler::tickFn)() = nullptr;
+void (*Scheduler::driverFn)() = nullptr;
+std::vector<Process*> Scheduler::carried;
+std::vector<Scheduler::SleepEntry> Scheduler::sleepQueue;
+uint64_t Scheduler::sleepSeq = 0;
+CommandQueue Scheduler::commands;
+std::mutex Scheduler::admitMutex;
+std::condition_variable Scheduler::eventCv;
+std::vector<Process*> Scheduler::admitted;
+std::atomic<int> Scheduler::liveProcesses{ 0 };
+std::atomic<uint64_t> Scheduler::pausedArrivals{ 0 };
+std::atomic<uint64_t> Scheduler::finishedCount{ 0 };
+std::atomic<uint64_t> Scheduler::totalWaiting{ 0 };
+std::atomic<uint64_t> Scheduler::totalTurnaround{ 0 };
+std::atomic<uint64_t> Scheduler::contextSwitches{ 0 };
+std::atomic<size_t> Scheduler::readyCount{ 0 };
+std::atomic<size_t> Scheduler::sleepingCount{ 0 };
+TraceBuffer* Scheduler::trace = nullptr;
+bool Scheduler::replaying = false;
+ReplayScript Scheduler::script;
+size_t Scheduler::nextArrival = 0;
+std::promise<void> Scheduler::replayDone;
+
+bool Scheduler::initialize() {
+    shutdown();
+    finishedCount = 0;
+    totalWaiting = 0;
+    totalTurnaround = 0;
+    if (!MemoryManager::initialize()) return false;
+    boot(nullptr);
+    return true;
 }
 
-void Scheduler::start() {
-    running = true;
+void Scheduler::restore(const SchedulerState& in) {
+    // the processes these held were replaced along with the process list
+    carried.clear();
+    for (const SchedulerState::OnCore& c : in.onCores) {
+        if (c.core >= Config::getNumCpu()) { // fewer cores now: it goes ahead of the queue
+            c.process->getSchedInfo().ready_since = in.tick;
+            carried.push_back(c.process);
+        }
+    }
+    sleepQueue.clear();
+    sleepSeq = 0;
+    for (const auto& [p, wakeTick] : in.sleeping) {
+        sleepQueue.push_back({ wakeTick, sleepSeq++, p });
+        std::push_heap(sleepQueue.begin(), sleepQueue.end(), std::greater<SleepEntry>());
+    }
+    {
+        std::lock_guard<std::mutex> lock(admitMutex);
+        admitted.clear();
+    }
+    currentTick = in.tick;
+    nextProcessId = in.nextProcessId;
+    tickCounter = in.tickCounter;
+    running = in.running;
+    liveProcesses = static_cast<int>(in.onCores.size() + in.ready.size() + in.sleeping.size());
+    pausedArrivals = in.pausedArrivals;
+    finishedCount = in.finishedCount;
+    totalWaiting = in.totalWaiting;
+    totalTurnaround = in.totalTurnaround;
+    boot(&in);
+}
+
+std::future<void> Scheduler::replay(ReplayScript in, const std::string& tracePath) {
+    if (!MemoryManager::initialize()) return {};
+    TraceHeader h = TraceHeader::fromConfig();
+    h.cores = static_cast<uint32_t>(Config::getNumCpu());
+    h.startTick = in.startTick;
+    h.firstPid = in.firstPid;
+    h.seed = in.seed;
+    h.scheduler = "replay";
+    if (!Trace::start(tracePath, h)) return {};
+
+    carried.clear();
+    sleepQueue.clear();
+    sleepSeq = 0;
+    {
+        std::lock_guard<std::mutex> lock(admitMutex);
+        admitted.clear();
+    }
+    currentTick = in.startTick;
+    nextProcessId = static_cast<int>(in.firstPid);
+    tickCounter = 0;
+    running = false; // arrivals come from the script
+    liveProcesses = 0;
+    pausedArrivals = 0;
+    finishedCount = 0;
+    totalWaiting = 0;
+    totalTurnaround = 0;
+    script = std::move(in);
+    nextArrival = 0;
+    replaying = true;
+    replayDone = std::promise<void>();
+    std::future<void> done = replayDone.get_future();
+    boot(nullptr);
+    return done;
+}
+
+// Scheduler thread, before the tick after the last recorded one.
+void Scheduler::finishReplay() {
+    Trace::stop(getCurrentTick());
+    attachTrace();
+    replaying = false;
+    replayDone.set_value();
+}
+
+bool Scheduler::startTrace(const std::string& path) {
+    bool ok = false;
+    call([&] {
+        if (!policy) {
+            std::cout << "Error: The scheduler is not running; run 'initialize' first.\n";
+            return;
+        }
+        TraceHeader h = TraceHeader::fromConfig();
+        h.cores = static_cast<uint32_t>(cores.size());
+        h.startTick = getCurrentTick();
+        h.firstPid = static_cast<uint32_t>(nextProcessId.load());
+        h.generated = ProcessGenerator::getTaken();
+        h.live = static_cast<uint64_t>(getLiveProcesses());
+        h.seed = ProcessGenerator::getSeed();
+        h.scheduler = policy->name();
+        ok = Trace::start(path, h);
+        attachTrace();
+    });
+    return ok;
+}
+
+void Scheduler::stopTrace() {
+    call([] {
+        if (!Trace::isRecording()) {
+            std::cout << "No trace is being recorded.\n";
+            return;
+        }
+        Trace::stop(getCurrentTick());
+        attachTrace();
+    });
+}
+
+void Scheduler::attachTrace() {
+    trace = Trace::buffer(static_cast<int>(cores.size()));
+    for (const auto& core : cores) core->setTrace(Trace::buffer(core->getId()));
+}
+
+// Between ticks: new cores join parked, departing ones are stopped and their process
+// is requeued with its level and waiting time intact. Utilization counts each core
+// from the tick it joined.
+bool Scheduler::resizeCores(int count) {
+    bool ok = false;
+    call([&] {
+        if (!policy) {
+            std::cout << "Error: The scheduler is not running; run 'initialize' first.\n";
+            return;
+        }
+        if (replaying || Trace::isRecording()) {
+            std::cout << "Error: Stop the trace before changing the number of cores.\n";
+            return;
+        }
+        uint64_t now = getCurrentTick();
+        int before = static_cast<int>(cores.size());
+        std::vector<std::unique_ptr<CpuCore>> departing;
+        {
+            std::unique_lock<std::shared_mutex> lock(coresMutex);
+            while (static_cast<int>(cores.size()) > count) {
+                departing.push_back(std::move(cores.back()));
+                cores.pop_back();
+            }
+            // placements extend the same sequence, so the cores that stay keep their CPU
+            placement = Topology::placement(Config::getCpuAffinity(), Config::getCpuList(), count);
+            while (static_cast<int>(cores.size()) < count) addCore(now);
+        }
+        policy->setCores(count);
+        policy->setStealOrder(Topology::stealOrder(placement));
+        int migrated = 0;
+        for (auto it = departing.rbegin(); it != departing.rend(); ++it) {
+            (*it)->stop();
+            if (Process* p = (*it)->release()) {
+                p->getSchedInfo().ready_since = now + 1; // it ran this tick
+                policy->enqueue(p, now + 1);
+                migrated++;
+            }
+        }
+        int busy = 0;
+        for (const auto& core : cores) {
+            if (!core->isIdle()) busy++;
+        }
+        busyCores = busy;
+        readyCount.store(policy->size(), std::memory_order_relaxed);
+        std::cout << "Cores: " << before << " -> " << count;
+        if (migrated > 0) std::cout << " (" << migrated << " running processes requeued)";
+        std::cout << "\n";
+        ok = true;
+    });
+    return ok;
+}
+
+void Scheduler::captureState(SchedulerState& out) {
+    out.tick = getCurrentTick();
+    out.nextProcessId = nextProcessId;
+    out.tickCounter = tickCounter;
+    out.running = running;
+    out.pausedArrivals = pausedArrivals;
+    out.finishedCount = finishedCount;
+    out.totalWaiting = totalWaiting;
+    out.totalTurnaround = totalTurnaround;
+
+    out.sleeping.clear();
+    std::vector<SleepEntry> sleepers = sleepQueue;
+    std::sort(sleepers.begin(), sleepers.end(), [](const SleepEntry& a, const SleepEntry& b) { return b > a; });
+    for (const SleepEntry& e : sleepers) out.sleeping.emplace_back(e.process, e.wakeTick);
+
+    out.onCores.clear();
+    for (const auto& core : cores) {
+        if (Process* p = core->getProcess()) out.onCores.push_back({ core->getId(), p, core->saveSlot() });
+    }
+    out.policy = policy ? policy->name() : "";
+    out.ready.clear();
+    for (Process* p : carried) out.ready.push_back({ p, -1, 0 });
+    if (policy) policy->save(out.ready, out.placement);
+    std::lock_guard<std::mutex> lock(admitMutex);
+    for (Process* p : admitted) out.ready.push_back({ p, -1, 0 });
+}
+
+void Scheduler::boot(const SchedulerState* from) {
     tickInterval = Config::getBatchProcessFreq();
+    profile = ExecProfile::fromConfig();
+    if (replaying) {
+        profile.virtualTime = true;
+        policy = std::make_unique<ReplayPolicy>(std::move(script.dispatches));
+    }
+    else {
+        policy = SchedulingPolicy::create(Config::getScheduler());
+    }
+    SchedulingPolicy* raw = policy.get();
+    if (dynamic_cast<ReplayPolicy*>(raw)) bindLoops<ReplayPolicy>();
+    else if (dynamic_cast<ShortestJobPolicy*>(raw)) bindLoops<ShortestJobPolicy>();
+    else if (dynamic_cast<PriorityPolicy*>(raw)) bindLoops<PriorityPolicy>();
+    else if (dynamic_cast<MlfqPolicy*>(raw)) bindLoops<MlfqPolicy>();
+    else bindLoops<FifoPolicy>();
+
+    policy->onTick(getCurrentTick()); // aging and boost periods carry on from the current tick
+    for (Process* p : carried) policy->enqueue(p, getCurrentTick());
+    carried.clear();
+    if (from) {
+        std::vector<SchedulingPolicy::Queued> ready = from->ready;
+        if (from->policy != policy->name()) { // saved queues and levels mean nothing to this policy
+            for (auto& q : ready) q.queue = -1;
+        }
+        policy->restore(ready, from->placement, getCurrentTick());
+    }
+    unsigned int seed = Config::hasRandomSeed() ? Config::getRandomSeed() : std::random_device{}();
+    ProcessGenerator::start(replaying ? script.seed : seed);
+    {
+        std::unique_lock<std::shared_mutex> lock(coresMutex);
+        placement = Topology::placement(Config::getCpuAffinity(), Config::getCpuList(), Config::getNumCpu());
+        for (int i = 0; i < Config::getNumCpu(); ++i) addCore(getCurrentTick());
+    }
+    policy->setStealOrder(Topology::stealOrder(placement));
+    if (from) {
+        for (const SchedulerState::OnCore& c : from->onCores) {
+            if (c.core < static_cast<int>(cores.size())) cores[c.core]->resume(c.process, c.slot);
+        }
+    }
+    attachTrace();
+
+    alive = true;
+    driver = std::thread(driverFn);
+}
+
+void Scheduler::addCore(uint64_t now) {
+    int id = static_cast<int>(cores.size());
+    auto core = std::make_unique<CpuCore>(id, tickSync);
+    core->setHostCpu(placement[id]);
+    core->setStartTick(now);
+    core->start(profile);
+    if (placement[id] >= 0 && !core->isPinned()) {
+        std::cout << "Warning: core " << id << " could not be pinned to CPU " << placement[id] << "; it runs unpinned.\n";
+    }
+    cores.push_back(std::move(core));
+}
+
+void Scheduler::shutdown() {
+    if (!driver.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(admitMutex);
+        alive = false;
+    }
+    eventCv.notify_all();
+    ProcessGenerator::stop(); // unblocks a scheduler thread waiting for a stream
+    driver.join();
+    Trace::stop(getCurrentTick());
+    trace = nullptr;
+
+    // processes that were on a core go ahead of the ready ones; the next policy requeues them
+    for (const auto& core : cores) {
+        core->stop();
+        if (Process* p = core->release()) {
+            p->getSchedInfo().ready_since = getCurrentTick();
+            carried.push_back(p);
+        }
+    }
+    policy->drain(carried);
+    policy.reset();
+    {
+        std::unique_lock<std::shared_mutex> lock(coresMutex);
+        cores.clear();
+        placement.clear();
+    }
+    MemoryManager::shutdown();
+    busyCores = 0;
+    readyCount = 0;
+    sleepingCount = 0;
+}
+
+void Scheduler::start() {
+    post([] { running = true; });
     std::cout << "Scheduler started. Generating a process every "
         << tickInterval << " ticks.\n";
 }
 
 void Scheduler::stop() {
-    running = false;
+    post([] { running = false; });
     std::cout << "Scheduler stopped.\n";
 }
 
@@ -30,78 +359,370 @@ bool Scheduler::isRunning() {
     return running;
 }
 
-void Scheduler::tick() {
-    if (!running) return;
-    tickCounter++;
-    if (tickCounter >= tickInterval) {
-        createDummyProcess();
-        tickCounter = 0;
+bool Scheduler::isBooted() {
+    return driver.joinable();
+}
+
+void Scheduler::post(CommandQueue::Command cmd) {
+    commands.post(std::move(cmd));
+    {
+        // pairs with the predicate check in skipIdleTime so the wake-up is not lost
+        std::lock_guard<std::mutex> lock(admitMutex);
     }
+    eventCv.notify_all();
 }
 
-std::string Scheduler::generateProcessName() {
-    std::string name = "p";
-    if (nextProcessId < 10) {
-        name += "0";
+void Scheduler::call(const std::function<void()>& fn) {
+    if (!driver.joinable() || std::this_thread::get_id() == driver.get_id()) {
+        fn();
+        return;
     }
-    name += std::to_string(nextProcessId++);
-    return name;
+    std::promise<void> done;
+    std::future<void> result = done.get_future();
+    post([&] {
+        try {
+            fn();
+            done.set_value();
+        }
+        catch (...) {
+            done.set_exception(std::current_exception());
+        }
+    });
+    result.get();
+}
+
+void Scheduler::admit(Process* p) {
+    liveProcesses.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(admitMutex);
+        admitted.push_back(p);
+    }
+    eventCv.notify_all();
+}
+
+uint64_t Scheduler::getCurrentTick() {
+    return currentTick.load(std::memory_order_relaxed);
+}
+
+int Scheduler::getBusyCores() {
+    return busyCores.load(std::memory_order_relaxed);
+}
+
+int Scheduler::getLiveProcesses() {
+    return liveProcesses.load(std::memory_order_relaxed);
+}
+
+uint64_t Scheduler::getPausedArrivals() {
+    return pausedArrivals.load(std::memory_order_relaxed);
 }
 
-std::vector<Instruction> generateDummyInstructions(int count) {
-    std::vector<Instruction> ins;
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> opDist(0, 5);
+uint64_t Scheduler::getFinishedCount() {
+    return finishedCount.load(std::memory_order_relaxed);
+}
+
+double Scheduler::getAvgWaitingTicks() {
+    uint64_t n = getFinishedCount();
+    return n ? static_cast<double>(totalWaiting.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+double Scheduler::getAvgTurnaroundTicks() {
+    uint64_t n = getFinishedCount();
+    return n ? static_cast<double>(totalTurnaround.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+uint64_t Scheduler::getGeneratedCount() {
+    return static_cast<uint64_t>(nextProcessId.load(std::memory_order_relaxed) - 1);
+}
+
+uint64_t Scheduler::getContextSwitches() {
+    return contextSwitches.load(std::memory_order_relaxed);
+}
+
+size_t Scheduler::getReadyCount() {
+    return readyCount.load(std::memory_order_relaxed);
+}
+
+size_t Scheduler::getSleepingCount() {
+    return sleepingCount.load(std::memory_order_relaxed);
+}
+
+// The cores only count in their own atomics; the lock just keeps the vector from
+// being rebuilt underneath the reader.
+void Scheduler::readCoreCounters(std::vector<CoreCounters>& out) {
+    out.clear();
+    std::shared_lock<std::shared_mutex> lock(coresMutex);
+    uint64_t now = getCurrentTick();
+    for (const auto& core : cores) {
+        uint64_t since = core->getStartTick();
+        uint64_t ticks = now > since ? now - since : 0;
+        uint64_t busy = core->getBusyTicks();
+        out.push_back({ core->getId(), busy, core->getInstructionsExecuted(),
+            ticks ? std::min(1.0, static_cast<double>(busy) / ticks) : 0.0 });
+    }
+}
+
+static void printIdleRow(const std::string& who, const IdleStats& s) {
+    uint64_t wakeups = s.wakeups.load(std::memory_order_relaxed);
+    uint64_t avgNs = wakeups ? s.wake_latency_ns.load(std::memory_order_relaxed) / wakeups : 0;
+    std::cout << "  " << std::left << std::setw(10) << who << std::right
+        << std::setw(12) << s.spin_hits.load(std::memory_order_relaxed)
+        << std::setw(10) << s.parks.load(std::memory_order_relaxed)
+        << std::setw(14) << avgNs / 1000.0
+        << std::setw(14) << s.wake_latency_max_ns.load(std::memory_order_relaxed) / 1000.0 << "\n";
+}
+
+void Scheduler::printTopology() {
+    std::vector<int> cpus;
+    std::vector<bool> pinned;
+    {
+        std::shared_lock<std::shared_mutex> lock(coresMutex);
+        cpus = placement;
+        for (const auto& core : cores) pinned.push_back(core->isPinned());
+    }
+    Topology::print(cpus, pinned);
+}
+
+void Scheduler::printIdleStats() {
+    std::cout << "===== Idle Wait Statistics =====\n";
+    std::cout << "  " << std::left << std::setw(10) << "waiter" << std::right
+        << std::setw(12) << "spin hits" << std::setw(10) << "parks"
+        << std::setw(14) << "avg wake us" << std::setw(14) << "max wake us" << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    for (const auto& core : cores) {
+        printIdleRow("core " + std::to_string(core->getId()), core->getIdleStats());
+    }
+    printIdleRow("scheduler", tickSync.getStats());
+    std::cout << std::defaultfloat;
+    std::cout << "================================\n";
+}
+
+void Scheduler::resetIdleStats() {
+    post([] {
+        for (const auto& core : cores) core->resetIdleStats();
+        tickSync.resetStats();
+    });
+}
+
+template <class P>
+void Scheduler::bindLoops() {
+    tickFn = [] { tickAs(static_cast<P&>(*policy)); };
+    driverFn = profile.virtualTime ? &driverLoop<P, true> : &driverLoop<P, false>;
+}
+
+template <class P, bool Virtual>
+void Scheduler::driverLoop() {
+    P& pol = static_cast<P&>(*policy);
+    auto next = std::chrono::steady_clock::now();
+    while (alive) {
+        tickAs(pol);
+        if constexpr (Virtual) {
+            // no wall-clock pacing; idle stretches are skipped outright
+            if (coresIdle() && pol.size() == 0) skipIdleTime();
+            continue;
+        }
+        next += std::chrono::milliseconds(TICK_MS);
+        std::this_thread::sleep_until(next);
+    }
+}
+
+bool Scheduler::coresIdle() {
+    for (const auto& core : cores) {
+        if (!core->isIdle()) return false;
+    }
+    return true;
+}
+
+// Virtual time, nothing runnable: move the clock to the tick just before the next
+// wake-up or batch arrival so that the next tick() lands exactly on it. Every skipped
+// tick would have been a no-op, so the schedule is the same as in real time.
+void Scheduler::skipIdleTime() {
+    std::unique_lock<std::mutex> lock(admitMutex);
+    if (!admitted.empty() || !commands.empty()) return;
+
+    uint64_t now = getCurrentTick();
+    uint64_t nextEvent = UINT64_MAX;
+    if (!sleepQueue.empty()) nextEvent = sleepQueue.front().wakeTick;
+    if (running) nextEvent = std::min<uint64_t>(nextEvent, now + (tickInterval - tickCounter));
+    if (replaying) {
+        nextEvent = std::min(nextEvent, script.endTick + 1); // lands on the tick that ends it
+        if (nextArrival < script.arrivals.size()) nextEvent = std::min(nextEvent, script.arrivals[nextArrival]);
+    }
 
-    for (int i = 0; i < count; ++i) {
-        Instruction instr;
-        int op = opDist(gen);
-        if (op == 0) {
-            instr.type = Instruction::PRINT;
-            instr.args = { "\"Hello world from <name>!\"" };
+    if (nextEvent == UINT64_MAX) {
+        // nothing will ever happen on its own; wait for the shell
+        eventCv.wait(lock, [] { return !admitted.empty() || !commands.empty() || !alive; });
+        return;
+    }
+
+    if (nextEvent > now + 1) {
+        uint64_t skip = nextEvent - now - 1;
+        currentTick.fetch_add(skip, std::memory_order_relaxed);
+        if (running) tickCounter += static_cast<int>(skip);
+    }
+}
+
+// One CPU tick: admit, wake sleepers, dispatch, run every busy core once, then
+// collect what each core's process did. Runs on the scheduler thread only.
+void Scheduler::tick() {
+    if (tickFn) tickFn();
+}
+
+template <class P>
+void Scheduler::tickAs(P& pol) {
+    commands.drain(); // shell requests take effect on a tick boundary
+    if (replaying && getCurrentTick() >= script.endTick) finishReplay();
+    uint64_t now = currentTick.fetch_add(1, std::memory_order_relaxed) + 1;
+    pol.onTick(now);
+    MemoryManager::beginTick(now);
+
+    if (running) {
+        tickCounter++;
+        if (tickCounter >= tickInterval) {
+            // backpressure: skip the arrival while too many processes are unfinished
+            int cap = Config::getMaxLiveProcesses();
+            if (cap == 0 || getLiveProcesses() < cap) createDummyProcess();
+            else pausedArrivals.fetch_add(1, std::memory_order_relaxed);
+            tickCounter = 0;
         }
-        else if (op == 1) {
-            instr.type = Instruction::DECLARE;
-            instr.args = { "x", "0" };
+    }
+    while (replaying && nextArrival < script.arrivals.size() && script.arrivals[nextArrival] <= now) {
+        nextArrival++;
+        createDummyProcess();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(admitMutex);
+        for (Process* p : admitted) {
+            p->getSchedInfo().arrival_tick = now;
+            if (trace) trace->add(TraceEvent::ARRIVE, now, -1, p->getSchedInfo().pid, static_cast<int64_t>(p->getTotalLines()));
+            makeReady(pol, p, now);
         }
-        else if (op == 2) {
-            instr.type = Instruction::ADD;
-            instr.args = { "x", "5", "10" };
+        admitted.clear();
+    }
+
+    while (!sleepQueue.empty() && sleepQueue.front().wakeTick <= now) {
+        std::pop_heap(sleepQueue.begin(), sleepQueue.end(), std::greater<SleepEntry>());
+        Process* p = sleepQueue.back().process;
+        if (trace) trace->add(TraceEvent::WAKE, now, -1, p->getSchedInfo().pid);
+        makeReady(pol, p, now);
+        sleepQueue.pop_back();
+    }
+
+    dispatch(pol, now);
+
+    int busy = 0;
+    for (const auto& core : cores) {
+        if (!core->isIdle()) busy++;
+    }
+    busyCores = busy;
+    readyCount.store(pol.size(), std::memory_order_relaxed);
+    sleepingCount.store(sleepQueue.size(), std::memory_order_relaxed);
+    PerfCounters::sampleQueues(pol.size(), sleepQueue.size(), busy);
+    if (busy == 0) return;
+
+    // targeted wake-up: idle cores stay parked
+    tickSync.begin(busy);
+    for (const auto& core : cores) {
+        if (!core->isIdle()) core->arm(now);
+    }
+    tickSync.waitAll();
+    collect(pol);
+}
+
+template <class P>
+void Scheduler::makeReady(P& pol, Process* p, uint64_t now) {
+    p->getSchedInfo().ready_since = now;
+    pol.enqueue(p, now);
+}
+
+template <class P>
+void Scheduler::dispatch(P& pol, uint64_t now) {
+    for (const auto& core : cores) {
+        if (pol.size() == 0) break;
+        if (!core->isIdle()) continue;
+        uint64_t dispatchStart = PerfCounters::start();
+        Process* p = pol.pickNext(core->getId(), now);
+        if (!p) continue; // replay: not this core's turn
+        SchedInfo& info = p->getSchedInfo();
+        info.waiting_ticks += now - info.ready_since;
+        info.last_core = core->getId();
+        int64_t budget = pol.budgetFor(*p);
+        if (TraceBuffer* t = core->getTrace()) t->add(TraceEvent::DISPATCH, now, core->getId(), info.pid, budget);
+        core->assign(p, budget);
+        contextSwitches.fetch_add(1, std::memory_order_relaxed);
+        PerfCounters::recordDispatch(dispatchStart);
+    }
+}
+
+template <class P>
+void Scheduler::collect(P& pol) {
+    uint64_t now = getCurrentTick();
+    for (const auto& core : cores) {
+        if (core->isIdle()) continue;
+        switch (core->getLastReason()) {
+        case YieldReason::QUANTUM: {
+            Process* p = core->release();
+            pol.onQuantumExpired(*p);
+            makeReady(pol, p, now + 1); // it ran this tick, so it only starts waiting at the next
+            break;
         }
-        else if (op == 3) {
-            instr.type = Instruction::SUBTRACT;
-            instr.args = { "x", "x", "1" };
+        case YieldReason::SLEEP:
+            sleepQueue.push_back({ now + core->getWaitTicks(), sleepSeq++, core->release() });
+            std::push_heap(sleepQueue.begin(), sleepQueue.end(), std::greater<SleepEntry>());
+            break;
+        case YieldReason::WAIT: {
+            // page faults are serviced here, in core order, so frame choice is deterministic.
+            // The process keeps its core and retries next tick; if every frame was pinned
+            // it simply faults again. A fault that cannot be serviced fails the process
+            // like an access violation.
+            Process* p = core->getProcess();
+            if (MemoryManager::serviceFault(p->getMemory()) != FaultResult::FAILED) break;
+            p->addLog("Error: Page fault could not be serviced; the backing store cannot grow");
+            if (TraceBuffer* t = core->getTrace()) t->add(TraceEvent::FINISH, now, core->getId(), p->getSchedInfo().pid, 0);
+            [[fallthrough]];
         }
-        else if (op == 4) {
-            instr.type = Instruction::SLEEP;
-            instr.args = { "2" };
+        case YieldReason::FINISHED: {
+            Process* p = core->release();
+            p->setFinished(true);
+            MemoryManager::release(p->getMemory());
+            liveProcesses.fetch_sub(1, std::memory_order_relaxed);
+            const SchedInfo& info = p->getSchedInfo();
+            totalWaiting.fetch_add(info.waiting_ticks, std::memory_order_relaxed);
+            totalTurnaround.fetch_add(now - info.arrival_tick + 1, std::memory_order_relaxed);
+            finishedCount.fetch_add(1, std::memory_order_relaxed);
+            break;
         }
-        else {
-            instr.type = Instruction::FOR;
-            instr.args = { "2" };
+        default:
+            break; // still running
         }
-        ins.push_back(instr);
     }
-    return ins;
+}
+
+std::string Scheduler::processName(uint32_t pid) {
+    std::string name = "p";
+    if (pid < 10) {
+        name += "0";
+    }
+    name += std::to_string(pid);
+    return name;
 }
 
 void Scheduler::createDummyProcess() {
-    std::string name = generateProcessName();
-    int minIns = Config::getMinIns();
-    int maxIns = Config::getMaxIns();
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(minIns, maxIns);
-    int numIns = dis(gen);
-    auto instructions = generateDummyInstructions(numIns);
-    Process newProc(name, instructions);
+    // the instruction stream was built ahead of time by the generator thread
+    uint64_t admitStart = PerfCounters::start();
+    int id = nextProcessId++;
+    Process* newProc = ProcessGenerator::next(processName(id));
+    if (!newProc) return;
+    newProc->getSchedInfo().pid = id;
     ScreenManager::addProcess(newProc); // storage is in screenmanager
+    admit(newProc);
+    PerfCounters::recordAdmission(admitStart);
 }
 
 void Scheduler::generateBatch(int count) {
-    for (int i = 0; i < count; ++i) {
-        createDummyProcess();
-    }
+    post([count] {
+        for (int i = 0; i < count; ++i) {
+            createDummyProcess();
+        }
+    });
 }
-
@@ -1,22 +1,165 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <shared_mutex>
 #include "Process.h"
+#include "CpuCore.h"
+#include "CommandQueue.h"
+#include "SchedulingPolicy.h"
+#include "InstructionExecutor.h"
+#include "Trace.h"
+
+// Scheduler side of a checkpoint: the counters, plus where each scheduled process waits.
+struct SchedulerState {
+    uint64_t tick = 0;
+    int nextProcessId = 1;
+    int tickCounter = 0;
+    bool running = false;
+    uint64_t pausedArrivals = 0;
+    uint64_t finishedCount = 0;
+    uint64_t totalWaiting = 0;
+    uint64_t totalTurnaround = 0;
+    struct OnCore {
+        int core;
+        Process* process;
+        CpuCore::Slot slot;
+    };
+    std::vector<OnCore> onCores;
+    std::string policy; // the queues and levels in ready belong to this policy
+    std::vector<SchedulingPolicy::Queued> ready;
+    uint64_t placement = 0;
+    std::vector<std::pair<Process*, uint64_t>> sleeping; // with their wake tick, in wake order
+};
+
+// What a replay runs: the arrivals and dispatches of a recorded trace, with the
+// generator reseeded the way it was when the recording started.
+struct ReplayScript {
+    unsigned int seed = 0;
+    uint64_t startTick = 0;
+    uint64_t endTick = 0;
+    uint32_t firstPid = 1;
+    std::vector<uint64_t> arrivals; // one tick per arrival, in order
+    std::vector<ReplayPolicy::Dispatch> dispatches;
+};
+
+// One core's running totals, as the metrics exporter reads them.
+struct CoreCounters {
+    int id;
+    uint64_t busyTicks;
+    uint64_t instructions;
+    double utilization; // busy share of the ticks since the core started
+};
 
 class Scheduler {
 public:
-    static void initialize(); // for resetting state
+    static bool initialize(); // (re)starts the cores for the loaded config; false leaves them shut down
+    static void shutdown();
+    static bool isBooted(); // initialize, restore or replay started the cores and nothing shut them down
+    static void captureState(SchedulerState& out); // scheduler thread, between ticks
+    static void restore(const SchedulerState& in); // like initialize, from a checkpoint; needs shutdown() first
+    static bool resizeCores(int count); // while running; a departing core's process goes back to the ready queue
+    static bool startTrace(const std::string& path); // records from the next tick on
+    static void stopTrace();
+    // Runs script under the replay policy in virtual time, recording to tracePath.
+    // Needs shutdown() first; the future is ready once the last scripted tick has run,
+    // and invalid when the replay could not start.
+    static std::future<void> replay(ReplayScript script, const std::string& tracePath);
+    static std::string processName(uint32_t pid); // p01, p02, ...
     static void createDummyProcess();
     static void generateBatch(int count = 5);
     static void start();
     static void stop();
     static bool isRunning();
-    static void tick();
+    static void tick(); // one tick of the loop bound for the current policy
+
+    static void admit(Process* p); // hand a new process to the ready queue (any thread)
+    static void post(CommandQueue::Command cmd); // run cmd on the scheduler thread
+    static void call(const std::function<void()>& fn); // post and wait; rethrows what fn throws
+    static uint64_t getCurrentTick();
+    static int getBusyCores();
+    static int getLiveProcesses();     // admitted and not yet finished
+    static uint64_t getPausedArrivals(); // arrivals skipped by max-live-processes
+    static uint64_t getFinishedCount();   // processes finished under the current policy
+    static double getAvgWaitingTicks();   // ticks spent ready but not on a core
+    static double getAvgTurnaroundTicks(); // arrival to finish
+    static uint64_t getGeneratedCount();   // processes created by the generator
+    static uint64_t getContextSwitches();  // processes put on a core
+    static size_t getReadyCount();         // as of the last tick
+    static size_t getSleepingCount();
+    static void readCoreCounters(std::vector<CoreCounters>& out); // any thread
+    static void printTopology(); // host CPUs and where the cores are pinned
+    static void printIdleStats();
+    static void resetIdleStats();
+
+    static constexpr int TICK_MS = 100; // wall-clock length of one tick
 
 private:
-    static int nextProcessId;
-    static std::string generateProcessName();
-    static bool running;
+    struct SleepEntry {
+        uint64_t wakeTick;
+        uint64_t seq; // keeps wake-up order deterministic for equal ticks
+        Process* process;
+        bool operator>(const SleepEntry& o) const {
+            return wakeTick != o.wakeTick ? wakeTick > o.wakeTick : seq > o.seq;
+        }
+    };
+
+    static std::atomic<int> nextProcessId;
+    static std::atomic<bool> running;
     static int tickCounter;
     static int tickInterval;
-};
\ No newline at end of file
+
+    static std::atomic<bool> alive;
+    static std::atomic<uint64_t> currentTick;
+    static std::atomic<int> busyCores;
+    static std::thread driver;
+    static TickSync tickSync;
+    static std::vector<std::unique_ptr<CpuCore>> cores;
+    static std::shared_mutex coresMutex; // taken by whatever rebuilds cores and by readers off the execution path
+    static std::vector<int> placement;   // host CPU of each core, -1 when not pinned
+    static std::unique_ptr<SchedulingPolicy> policy; // owns the ready set
+    static ExecProfile profile;
+    static void (*tickFn)();
+    static void (*driverFn)();
+    static std::vector<Process*> carried; // ready processes kept across a re-initialize
+    static std::vector<SleepEntry> sleepQueue; // min-heap on wakeTick
+    static uint64_t sleepSeq;
+    static CommandQueue commands;
+    static std::mutex admitMutex;
+    static std::condition_variable eventCv; // virtual time: wakes an idle scheduler thread
+    static std::vector<Process*> admitted;
+    static std::atomic<int> liveProcesses;
+    static std::atomic<uint64_t> pausedArrivals;
+    static std::atomic<uint64_t> finishedCount;
+    static std::atomic<uint64_t> totalWaiting;
+    static std::atomic<uint64_t> totalTurnaround;
+    static std::atomic<uint64_t> contextSwitches;
+    static std::atomic<size_t> readyCount;
+    static std::atomic<size_t> sleepingCount;
+    static TraceBuffer* trace; // the scheduler's own events; null while not recording
+    static bool replaying;
+    static ReplayScript script;
+    static size_t nextArrival; // into script.arrivals
+    static std::promise<void> replayDone;
+
+    // The per-tick loops are compiled once per concrete policy (all of them final), so
+    // ready-set calls are direct; bindLoops<P>() picks them when the policy is built.
+    template <class P> static void bindLoops();
+    template <class P, bool Virtual> static void driverLoop();
+    template <class P> static void tickAs(P& pol);
+    template <class P> static void makeReady(P& pol, Process* p, uint64_t now);
+    template <class P> static void dispatch(P& pol, uint64_t now);
+    template <class P> static void collect(P& pol);
+    static void boot(const SchedulerState* from); // policy, generator, cores and driver; from a checkpoint if given
+    static void addCore(uint64_t now); // the next core id, on its placement; coresMutex held
+    static void attachTrace(); // points the cores and the scheduler at the trace buffers
+    static void finishReplay();
+    static bool coresIdle();
+    static void skipIdleTime();
+};
@@ -0,0 +1,305 @@
+#include "SchedulingPolicy.h"
+#include <algorithm>
+#include <bit>
+#include "Config.h"
+
+std::unique_ptr<SchedulingPolicy> SchedulingPolicy::create(const std::string& name) {
+    int64_t quantum = Config::getQuantumCycles();
+    if (name == "rr") return std::make_unique<FifoPolicy>(quantum);
+    if (name == "sjf") return std::make_unique<ShortestJobPolicy>(false);
+    if (name == "srtf") return std::make_unique<ShortestJobPolicy>(true);
+    int cores = Config::getNumCpu();
+    if (name == "priority") return std::make_unique<PriorityPolicy>(cores, quantum, Config::getAgingInterval());
+    if (name == "mlfq") {
+        return std::make_unique<MlfqPolicy>(cores, quantum, Config::getMlfqLevels(), Config::getMlfqBoostInterval());
+    }
+    return std::make_unique<FifoPolicy>(-1);
+}
+
+static size_t remainingLines(const Process* p) {
+    return p->getTotalLines() - p->getCurrentLine();
+}
+
+// heap order: true when a should run after b
+static bool runsAfter(const Process* a, const Process* b) {
+    size_t ra = remainingLines(a), rb = remainingLines(b);
+    return ra != rb ? ra > rb : a->getSchedInfo().seq > b->getSchedInfo().seq;
+}
+
+void SchedulingPolicy::restore(const std::vector<Queued>& in, uint64_t /*cursor*/, uint64_t now) {
+    for (const Queued& q : in) enqueue(q.process, now);
+}
+
+// ---------- FifoPolicy ----------
+
+void FifoPolicy::enqueue(Process* p, uint64_t /*now*/) {
+    stamp(p);
+    ready.push_back(p);
+}
+
+Process* FifoPolicy::pickNext(int /*core*/, uint64_t /*now*/) {
+    if (ready.empty()) return nullptr;
+    Process* p = ready.front();
+    ready.pop_front();
+    return p;
+}
+
+void FifoPolicy::drain(std::vector<Process*>& out) {
+    out.insert(out.end(), ready.begin(), ready.end());
+    ready.clear();
+}
+
+void FifoPolicy::save(std::vector<Queued>& out, uint64_t& cursor) const {
+    for (Process* p : ready) out.push_back({ p, 0, 0 });
+    cursor = 0;
+}
+
+// ---------- ShortestJobPolicy ----------
+
+void ShortestJobPolicy::enqueue(Process* p, uint64_t /*now*/) {
+    stamp(p);
+    ready.push_back(p);
+    std::push_heap(ready.begin(), ready.end(), runsAfter);
+}
+
+Process* ShortestJobPolicy::pickNext(int /*core*/, uint64_t /*now*/) {
+    if (ready.empty()) return nullptr;
+    std::pop_heap(ready.begin(), ready.end(), runsAfter);
+    Process* p = ready.back();
+    ready.pop_back();
+    return p;
+}
+
+void ShortestJobPolicy::drain(std::vector<Process*>& out) {
+    while (Process* p = pickNext(0, 0)) out.push_back(p);
+}
+
+void ShortestJobPolicy::save(std::vector<Queued>& out, uint64_t& cursor) const {
+    std::vector<Process*> order = ready;
+    std::sort(order.begin(), order.end(), [](const Process* a, const Process* b) { return runsAfter(b, a); });
+    for (Process* p : order) out.push_back({ p, 0, 0 });
+    cursor = 0;
+}
+
+// ---------- RunQueuePolicy ----------
+
+void RunQueuePolicy::push(Process* p, int level) {
+    int home = p->getSchedInfo().last_core;
+    if (home < 0 || home >= static_cast<int>(queues.size())) {
+        home = static_cast<int>(nextHome++ % queues.size());
+    }
+    pushTo(home, p, level);
+}
+
+void RunQueuePolicy::pushTo(size_t queue, Process* p, int level) {
+    queues[queue].push(p, level);
+    levelCount[level]++;
+    summary |= RunQueue::bitFor(level);
+    count++;
+}
+
+Process* RunQueuePolicy::popFrom(RunQueue& q, int level) {
+    Process* p = q.popLevel(level);
+    if (--levelCount[level] == 0) summary &= ~RunQueue::bitFor(level);
+    count--;
+    return p;
+}
+
+Process* RunQueuePolicy::pickNext(int core, uint64_t /*now*/) {
+    if (count == 0) return nullptr;
+    int best = std::countl_zero(summary);
+    uint64_t bit = RunQueue::bitFor(best);
+    size_t n = queues.size();
+    size_t self = static_cast<size_t>(core) % n;
+    if (self < stealOrder.size()) {
+        // own queue, then the nearest core that has the level
+        if (queues[self].occupancy() & bit) return popFrom(queues[self], best);
+        for (int other : stealOrder[self]) {
+            if (queues[other].occupancy() & bit) return popFrom(queues[other], best);
+        }
+        return nullptr;
+    }
+    // own queue first, then steal from the next core round the ring that has the level
+    for (size_t i = 0; i < n; ++i) {
+        RunQueue& q = queues[(self + i) % n];
+        if (q.occupancy() & bit) return popFrom(q, best);
+    }
+    return nullptr;
+}
+
+void RunQueuePolicy::setStealOrder(std::vector<std::vector<int>> order) {
+    stealOrder.clear();
+    if (order.size() != queues.size()) return;
+    for (const auto& others : order) {
+        for (int o : others) {
+            if (o < 0 || o >= static_cast<int>(queues.size())) return;
+        }
+    }
+    stealOrder = std::move(order);
+}
+
+void RunQueuePolicy::setCores(int cores) {
+    stealOrder.clear(); // the scheduler sets the order for the new count
+    size_t n = static_cast<size_t>(std::max(cores, 1));
+    if (n >= queues.size()) {
+        queues.resize(n);
+        return;
+    }
+    // levels and FIFO order survive; the processes are dealt out round robin
+    std::vector<Queued> moved;
+    for (size_t i = n; i < queues.size(); ++i) {
+        queues[i].forEach([&](Process* p, int level) { moved.push_back({ p, static_cast<int>(i), level }); });
+    }
+    for (const Queued& q : moved) {
+        if (--levelCount[q.level] == 0) summary &= ~RunQueue::bitFor(q.level);
+        count--;
+    }
+    queues.resize(n);
+    for (const Queued& q : moved) pushTo(nextHome++ % n, q.process, q.level);
+}
+
+void RunQueuePolicy::promoteWaiting(uint64_t now, uint64_t interval) {
+    for (size_t i = 0; i < queues.size(); ++i) {
+        RunQueue& q = queues[i];
+        if (!(q.occupancy() & ~RunQueue::bitFor(0))) continue; // empty, or level 0 only
+        // worst level first, so after skipped ticks a process can climb more than once
+        for (int level = 63 - std::countr_zero(q.occupancy()); level > 0; --level) {
+            while (Process* p = q.head(level)) {
+                const SchedInfo& info = p->getSchedInfo();
+                // it reached this level (priority - level) intervals after it became ready
+                uint64_t due = info.ready_since + static_cast<uint64_t>(info.priority - level + 1) * interval;
+                if (due > now) break;
+                popFrom(q, level);
+                pushTo(i, p, level - 1);
+            }
+        }
+    }
+}
+
+void RunQueuePolicy::mergeAllInto(int level) {
+    for (auto& q : queues) q.mergeInto(level);
+    std::fill(std::begin(levelCount), std::end(levelCount), 0);
+    levelCount[level] = static_cast<uint32_t>(count);
+    summary = count ? RunQueue::bitFor(level) : 0;
+}
+
+void RunQueuePolicy::save(std::vector<Queued>& out, uint64_t& cursor) const {
+    for (size_t i = 0; i < queues.size(); ++i) {
+        queues[i].forEach([&](Process* p, int level) { out.push_back({ p, static_cast<int>(i), level }); });
+    }
+    cursor = nextHome;
+}
+
+void RunQueuePolicy::restore(const std::vector<Queued>& in, uint64_t cursor, uint64_t now) {
+    nextHome = cursor;
+    for (const Queued& q : in) {
+        if (q.queue < 0 || q.queue >= static_cast<int>(queues.size()) || q.level < 0 || q.level >= RunQueue::LEVELS) {
+            enqueue(q.process, now);
+            continue;
+        }
+        stamp(q.process);
+        pushTo(q.queue, q.process, q.level); // aged or boosted levels stay as they were
+    }
+}
+
+void RunQueuePolicy::drain(std::vector<Process*>& out) {
+    for (auto& q : queues) q.drain(out);
+    std::fill(std::begin(levelCount), std::end(levelCount), 0);
+    summary = 0;
+    count = 0;
+}
+
+// ---------- PriorityPolicy ----------
+
+void PriorityPolicy::enqueue(Process* p, uint64_t /*now*/) {
+    stamp(p);
+    push(p, p->getSchedInfo().priority);
+}
+
+void PriorityPolicy::onTick(uint64_t now) {
+    promoteWaiting(now, static_cast<uint64_t>(agingInterval));
+}
+
+// ---------- MlfqPolicy ----------
+
+void MlfqPolicy::applyBoost(SchedInfo& info) const {
+    if (info.boost_epoch != epoch) {
+        // it was away (new, sleeping or on a core) or queued when the last boost happened
+        info.level = 0;
+        info.boost_epoch = epoch;
+    }
+}
+
+void MlfqPolicy::enqueue(Process* p, uint64_t /*now*/) {
+    SchedInfo& info = p->getSchedInfo();
+    applyBoost(info);
+    stamp(p);
+    push(p, info.level);
+}
+
+Process* MlfqPolicy::pickNext(int core, uint64_t now) {
+    Process* p = RunQueuePolicy::pickNext(core, now);
+    if (p) applyBoost(p->getSchedInfo());
+    return p;
+}
+
+int64_t MlfqPolicy::budgetFor(const Process& p) const {
+    return quantum << p.getSchedInfo().level;
+}
+
+void MlfqPolicy::onQuantumExpired(Process& p) {
+    SchedInfo& info = p.getSchedInfo();
+    if (info.level + 1 < levels) info.level++;
+}
+
+void MlfqPolicy::onTick(uint64_t now) {
+    uint64_t current = now / static_cast<uint64_t>(boostInterval);
+    if (current == epoch) return;
+    epoch = current;
+    // the boost is derived from the tick number, so skipped idle ticks cannot miss one;
+    // queued processes pick up their new level when they are dispatched
+    mergeAllInto(0);
+}
+
+// ---------- ReplayPolicy ----------
+
+void ReplayPolicy::enqueue(Process* p, uint64_t /*now*/) {
+    stamp(p);
+    ready.emplace(p->getSchedInfo().pid, p);
+}
+
+Process* ReplayPolicy::pickNext(int core, uint64_t now) {
+    // entries this run has gone past (their core was busy) are dropped
+    while (next < script.size() && (script[next].tick < now || (script[next].tick == now && script[next].core < core))) {
+        next++;
+    }
+    if (next == script.size() || script[next].tick != now || script[next].core != core) return nullptr;
+    const Dispatch& d = script[next++];
+    auto it = ready.find(d.pid);
+    if (it == ready.end()) return nullptr;
+    Process* p = it->second;
+    ready.erase(it);
+    budget = d.budget;
+    return p;
+}
+
+std::vector<Process*> ReplayPolicy::inArrivalOrder() const {
+    std::vector<Process*> order;
+    order.reserve(ready.size());
+    for (const auto& [pid, p] : ready) order.push_back(p);
+    std::sort(order.begin(), order.end(), [](const Process* a, const Process* b) {
+        return a->getSchedInfo().seq < b->getSchedInfo().seq;
+    });
+    return order;
+}
+
+void ReplayPolicy::drain(std::vector<Process*>& out) {
+    std::vector<Process*> order = inArrivalOrder();
+    out.insert(out.end(), order.begin(), order.end());
+    ready.clear();
+}
+
+void ReplayPolicy::save(std::vector<Queued>& out, uint64_t& cursor) const {
+    for (Process* p : inArrivalOrder()) out.push_back({ p, 0, 0 });
+    cursor = 0;
+}
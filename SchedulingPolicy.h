@@ -0,0 +1,200 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Process.h"
+#include "RunQueue.h"
+
+// Decides which ready process runs next and for how long. The scheduler owns the
+// ready set through this interface and calls it on the scheduler thread only.
+class SchedulingPolicy {
+public:
+    virtual ~SchedulingPolicy() = default;
+
+    // Builds the policy named by the scheduler key of the loaded config.
+    static std::unique_ptr<SchedulingPolicy> create(const std::string& name);
+
+    virtual const char* name() const = 0;
+
+    // p can run from tick now on (arrival, wake-up or end of its quantum).
+    virtual void enqueue(Process* p, uint64_t now) = 0;
+    virtual Process* pickNext(int core, uint64_t now) = 0; // for an idle core; nullptr when nothing is ready
+    virtual size_t size() const = 0;
+    bool empty() const { return size() == 0; }
+
+    // Cycles p may run before it is preempted; -1 runs it until it blocks or finishes.
+    virtual int64_t budgetFor(const Process& p) const = 0;
+    virtual void onQuantumExpired(Process& /*p*/) {}
+    virtual void onTick(uint64_t /*now*/) {}
+    virtual void setCores(int /*cores*/) {} // the core count changed while processes wait
+    // Per core, the other cores to take work from, nearest first; empty keeps ring order.
+    virtual void setStealOrder(std::vector<std::vector<int>> /*order*/) {}
+
+    // Empties the ready set into out, best candidate first.
+    virtual void drain(std::vector<Process*>& out) = 0;
+
+    // Checkpoint support. save lists the ready set with the run queue and level each
+    // process waits in (0 for single-queue policies) plus the placement cursor;
+    // restore puts them back in the same order. Entries with queue -1 are enqueued.
+    struct Queued {
+        Process* process;
+        int queue;
+        int level;
+    };
+    virtual void save(std::vector<Queued>& out, uint64_t& cursor) const = 0;
+    virtual void restore(const std::vector<Queued>& in, uint64_t cursor, uint64_t now);
+
+protected:
+    uint64_t nextSeq = 0;
+    void stamp(Process* p) { p->getSchedInfo().seq = nextSeq++; }
+};
+
+// fcfs and rr: one FIFO queue; rr preempts after quantum-cycles.
+class FifoPolicy final : public SchedulingPolicy {
+public:
+    explicit FifoPolicy(int64_t quantum) : quantum(quantum) {}
+
+    const char* name() const override { return quantum < 0 ? "fcfs" : "rr"; }
+    void enqueue(Process* p, uint64_t now) override;
+    Process* pickNext(int core, uint64_t now) override;
+    size_t size() const override { return ready.size(); }
+    int64_t budgetFor(const Process& /*p*/) const override { return quantum; }
+    void drain(std::vector<Process*>& out) override;
+    void save(std::vector<Queued>& out, uint64_t& cursor) const override;
+
+private:
+    int64_t quantum;
+    std::deque<Process*> ready;
+};
+
+// sjf and srtf: the fewest remaining lines first. srtf re-decides after every
+// cycle, so a shorter arrival takes the core at the next tick. A queued process does
+// not advance, so its key is fixed while it sits in the heap.
+class ShortestJobPolicy final : public SchedulingPolicy {
+public:
+    explicit ShortestJobPolicy(bool preemptive) : preemptive(preemptive) {}
+
+    const char* name() const override { return preemptive ? "srtf" : "sjf"; }
+    void enqueue(Process* p, uint64_t now) override;
+    Process* pickNext(int core, uint64_t now) override;
+    size_t size() const override { return ready.size(); }
+    int64_t budgetFor(const Process& /*p*/) const override { return preemptive ? 1 : -1; }
+    void drain(std::vector<Process*>& out) override;
+    void save(std::vector<Queued>& out, uint64_t& cursor) const override;
+
+private:
+    bool preemptive;
+    std::vector<Process*> ready; // min-heap on (remaining lines, seq)
+};
+
+// Base for the leveled policies: one RunQueue per core. A process goes back to the
+// queue of the core it last ran on; new ones are spread round robin. An idle core
+// takes the best level anywhere, preferring its own queue when that level is there
+// and then the cores nearest to it on the host when the cores are pinned.
+class RunQueuePolicy : public SchedulingPolicy {
+public:
+    explicit RunQueuePolicy(int cores) : queues(cores) {}
+
+    Process* pickNext(int core, uint64_t now) override;
+    size_t size() const override { return count; }
+    void setCores(int cores) override; // queues of departing cores move to the remaining ones
+    void setStealOrder(std::vector<std::vector<int>> order) override;
+    void drain(std::vector<Process*>& out) override;
+    void save(std::vector<Queued>& out, uint64_t& cursor) const override;
+    void restore(const std::vector<Queued>& in, uint64_t cursor, uint64_t now) override;
+
+protected:
+    void push(Process* p, int level);
+    // Priority aging: a process moves up one level for every interval it has waited.
+    // Only the heads of the FIFOs are looked at; each FIFO is in the order its
+    // processes came to that level, so the rest are not due yet.
+    void promoteWaiting(uint64_t now, uint64_t interval);
+    void mergeAllInto(int level);
+
+private:
+    std::vector<RunQueue> queues;
+    std::vector<std::vector<int>> stealOrder; // empty: the next cores round the ring
+    uint32_t levelCount[RunQueue::LEVELS] = {};
+    uint64_t summary = 0; // union of the per-core bitmaps
+    size_t count = 0;
+    size_t nextHome = 0;
+
+    Process* popFrom(RunQueue& q, int level);
+    void pushTo(size_t queue, Process* p, int level);
+};
+
+// priority: lowest priority value first, round robin within the quantum. A process
+// moves up a level for every aging-interval ticks it has waited, so nothing starves;
+// it drops back to its own priority when it is requeued.
+class PriorityPolicy final : public RunQueuePolicy {
+public:
+    PriorityPolicy(int cores, int64_t quantum, int agingInterval)
+        : RunQueuePolicy(cores), quantum(quantum), agingInterval(agingInterval) {}
+
+    const char* name() const override { return "priority"; }
+    void enqueue(Process* p, uint64_t now) override;
+    int64_t budgetFor(const Process& /*p*/) const override { return quantum; }
+    void onTick(uint64_t now) override;
+
+private:
+    int64_t quantum;
+    int agingInterval;
+};
+
+// mlfq: new processes start in the top queue with a quantum of quantum-cycles; each
+// lower queue doubles it. Using a whole quantum demotes a process, blocking keeps its
+// level, and every mlfq-boost-interval ticks all processes go back to the top.
+class MlfqPolicy final : public RunQueuePolicy {
+public:
+    MlfqPolicy(int cores, int64_t quantum, int levels, int boostInterval)
+        : RunQueuePolicy(cores), quantum(quantum), levels(levels), boostInterval(boostInterval) {}
+
+    const char* name() const override { return "mlfq"; }
+    void enqueue(Process* p, uint64_t now) override;
+    Process* pickNext(int core, uint64_t now) override;
+    int64_t budgetFor(const Process& p) const override;
+    void onQuantumExpired(Process& p) override;
+    void onTick(uint64_t now) override;
+
+private:
+    int64_t quantum;
+    int levels;
+    int boostInterval;
+    uint64_t epoch = 0;
+
+    void applyBoost(SchedInfo& info) const;
+};
+
+// replay: runs a recorded schedule. An idle core gets the process the trace
+// dispatched on it at this tick, with the recorded budget. If that process is not
+// ready (the run has diverged from the recording) the core stays idle.
+class ReplayPolicy final : public SchedulingPolicy {
+public:
+    struct Dispatch {
+        uint64_t tick;
+        int core;
+        uint32_t pid;
+        int64_t budget;
+    };
+
+    explicit ReplayPolicy(std::vector<Dispatch> script) : script(std::move(script)) {}
+
+    const char* name() const override { return "replay"; }
+    void enqueue(Process* p, uint64_t now) override;
+    Process* pickNext(int core, uint64_t now) override;
+    size_t size() const override { return ready.size(); }
+    int64_t budgetFor(const Process& /*p*/) const override { return budget; }
+    void drain(std::vector<Process*>& out) override;
+    void save(std::vector<Queued>& out, uint64_t& cursor) const override;
+
+private:
+    std::vector<Dispatch> script; // in tick and then core order
+    size_t next = 0;
+    int64_t budget = -1; // of the last process picked
+    std::unordered_map<uint32_t, Process*> ready;
+
+    std::vector<Process*> inArrivalOrder() const;
+};
@@ -1,37 +1,95 @@
 #include "ScreenManager.h"
 #include <random>
 #include "Config.h"
+#include "Scheduler.h"
+#include "ProcessGenerator.h"
+#include "MemoryManager.h"
+#include "ReportUtil.h"
+#include "Checkpoint.h"
 #include <iostream>
 #include <iterator>
 #include <algorithm>
 #include <sstream>
 #include <fstream>
 #include <iomanip>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
 
-std::vector<Process> global_processes;
+std::vector<Process*> global_processes; // blocks come from the Process pool
+std::mutex global_processes_mtx;        // the scheduler thread adds while the shell reads
+static uint64_t global_processes_generation = 0; // bumped when the list is replaced
+static ReportWriter utilizationLog("csopesy-log.txt");
 
 Process* getProcessByName(const std::string& name) {
-    for (auto& p : global_processes) {
-        if (p.getName() == name && !p.isFinished()) {
-            return &p;
+    std::lock_guard<std::mutex> lock(global_processes_mtx);
+    for (Process* p : global_processes) {
+        if (p->getName() == name && !p->isFinished()) {
+            return p;
         }
     }
     return nullptr;
 }
 
-std::vector<Process>& ScreenManager::getProcesses() {
+// Reads a published snapshot only, so it is safe while a core runs the process.
+static void printProcessSmi(const Process& proc, size_t procID) {
+    ProcessSnapshot snap = proc.snapshot();
+
+    std::cout << "\nProcess name: " << proc.getName() << "\n";
+    std::cout << "ID: " << procID << "\n";
+    std::cout << "Logs:\n";
+
+    const auto logs = proc.getLogs(snap.log_count);
+    if (logs.empty()) {
+        std::cout << "(No logs yet)\n";
+    }
+    else {
+        for (const auto& log : logs) {
+            std::cout << log << "\n";
+        }
+    }
+
+    if (snap.var_count > 0) {
+        std::cout << "Variables:";
+        for (uint32_t i = 0; i < snap.var_count; ++i) {
+            std::cout << " " << snap.vars[i].name << "=" << snap.vars[i].value;
+        }
+        if (snap.var_total > snap.var_count) std::cout << " (+" << snap.var_total - snap.var_count << " more)";
+        std::cout << "\n";
+    }
+
+    std::cout << "Current instruction line: " << snap.current_line << "\n";
+    std::cout << "Lines of code: " << snap.total_lines << "\n";
+    if (snap.finished) std::cout << "Finished!\n";
+}
+
+std::vector<Process*>& ScreenManager::getProcesses() {
     return global_processes;
 }
 
-void ScreenManager::addProcess(const Process& p) {
+void ScreenManager::addProcess(Process* p) {
+    std::lock_guard<std::mutex> lock(global_processes_mtx);
     global_processes.push_back(p);
 }
 
+void ScreenManager::replaceProcesses(std::vector<Process*> processes) {
+    Checkpoint::wait(); // a checkpoint still being written reads the old processes
+    std::lock_guard<std::mutex> lock(global_processes_mtx);
+    for (Process* p : global_processes) {
+        MemoryManager::release(p->getMemory());
+        Process::destroy(p);
+    }
+    global_processes = std::move(processes);
+    global_processes_generation++;
+}
+
 void ScreenManager::listProcesses() {
+    std::lock_guard<std::mutex> lock(global_processes_mtx);
     bool found = false;
-    for (const auto& p : global_processes) {
-        if (!p.isFinished()) {
-            std::cout << p.getName() << "\n";
+    for (const Process* p : global_processes) {
+        if (!p->isFinished()) {
+            std::cout << p->getName() << "\n";
             found = true;
         }
     }
@@ -41,10 +99,11 @@ void ScreenManager::listProcesses() {
 }
 
 void ScreenManager::createAndAttach(const std::string& name) {
+    std::unique_lock<std::mutex> lock(global_processes_mtx);
     // Check if process with same name already exists and is running
     auto it = std::find_if(global_processes.begin(), global_processes.end(),
-        [&](const Process& p) {
-            return p.getName() == name && !p.isFinished();
+        [&](const Process* p) {
+            return p->getName() == name && !p->isFinished();
         });
 
     if (it != global_processes.end()) {
@@ -53,16 +112,18 @@ void ScreenManager::createAndAttach(const std::string& name) {
     }
 
     // int minIns = Config::getMinIns();
-    std::vector<Instruction> instructions;
+    InstructionList instructions;
     /*Instruction printInstr;
     printInstr.type = Instruction::PRINT;
     printInstr.args = { "\"Hello world from <name>!\"" };
     instructions.push_back(printInstr);
     */
-    Process newProc(name, instructions);
-    global_processes.push_back(newProc);
-    Process& procRef = global_processes.back();
+    global_processes.push_back(Process::create(name, std::move(instructions)));
+    Process& procRef = *global_processes.back();
+    MemoryManager::attach(procRef.getMemory(), static_cast<uint32_t>(Config::getMinMemPerProc()));
     size_t procID = global_processes.size(); //id
+    lock.unlock();
+    procRef.setEchoOutput(true);
 
     std::string cmd;
     while (true) {
@@ -74,26 +135,7 @@ void ScreenManager::createAndAttach(const std::string& name) {
             break;
         }
         else if (cmd == "process-smi") {
-            std::cout << "\nProcess name: " << name << "\n";
-            std::cout << "ID: " << procID << "\n";
-            std::cout << "Logs:\n";
-
-            const auto& logs = procRef.getLogs();
-            if (logs.empty()) {
-                std::cout << "(No logs yet)\n";
-            }
-            else {
-                for (const auto& log : logs) {
-                    std::cout << log << "\n";
-                }
-            }
-
-            std::cout << "Current instruction line: " << procRef.getCurrentLine() << "\n";
-            std::cout << "Lines of code: " << procRef.getTotalLines() << "\n";
-            // TEMP: execute next instruction on every process-smi (for testing)
-            if (!procRef.isFinished()) {
-                procRef.executeNextInstruction();
-            }
+            printProcessSmi(procRef, procID);
         }
         else { // Manual instruction parser - robust version
             // trim leading spaces
@@ -139,6 +181,7 @@ void ScreenManager::createAndAttach(const std::string& name) {
                     instr.args = { content };
                     procRef.executeInstruction(instr);
                     procRef.addLog("Executed PRINT literal (quoted): " + content);
+                    procRef.publishSnapshot(Scheduler::getCurrentTick());
                 }
 
                 else {
@@ -148,6 +191,7 @@ void ScreenManager::createAndAttach(const std::string& name) {
                         instr.args = {};
                         procRef.executeInstruction(instr);
                         procRef.addLog("Executed PRINT (default)");
+                        procRef.publishSnapshot(Scheduler::getCurrentTick());
                     }
                     else {
                         std::vector<std::string> args;
@@ -157,14 +201,15 @@ void ScreenManager::createAndAttach(const std::string& name) {
                         std::string tok;
                         while (issArgs >> tok) args.push_back(tok);
                         instr.type = Instruction::PRINT;
-                        instr.args = args;
+                        instr.args.assign(args.begin(), args.end());
                         procRef.executeInstruction(instr);
                         procRef.addLog("Executed PRINT with args");
+                        procRef.publishSnapshot(Scheduler::getCurrentTick());
                     }
                 }
             }
             else if (cmdUpper == "DECLARE" || cmdUpper == "ADD" || cmdUpper == "SUBTRACT" ||
-                cmdUpper == "SLEEP" || cmdUpper == "FOR") {
+                cmdUpper == "SLEEP" || cmdUpper == "FOR" || cmdUpper == "READ" || cmdUpper == "WRITE") {
                 std::string argstr;
                 size_t pOpen = line.find('(');
                 size_t pClose = line.rfind(')');
@@ -189,10 +234,13 @@ void ScreenManager::createAndAttach(const std::string& name) {
                 else if (cmdUpper == "SUBTRACT") instr.type = Instruction::SUBTRACT;
                 else if (cmdUpper == "SLEEP") instr.type = Instruction::SLEEP;
                 else if (cmdUpper == "FOR") instr.type = Instruction::FOR;
+                else if (cmdUpper == "READ") instr.type = Instruction::READ;
+                else if (cmdUpper == "WRITE") instr.type = Instruction::WRITE;
 
-                instr.args = args;
+                instr.args.assign(args.begin(), args.end());
                 procRef.executeInstruction(instr);
                 procRef.addLog("Executed " + cmdUpper);
+                procRef.publishSnapshot(Scheduler::getCurrentTick());
             }
             else {
                 std::cout << "Unknown instruction: " << cmdName << "\n";
@@ -201,10 +249,37 @@ void ScreenManager::createAndAttach(const std::string& name) {
     }
 }
 
+// Streams new log lines from snapshots until Enter is pressed. The follower only reads
+// the seqlock and the published part of the log list, so it never stalls the cores.
+static void followLogs(const Process& proc) {
+    std::atomic<bool> stop{ false };
+    std::cout << "Following " << proc.getName() << " (press Enter to stop)\n";
+
+    std::thread follower([&proc, &stop] {
+        size_t seen = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            ProcessSnapshot snap = proc.snapshot();
+            for (const auto& line : proc.getLogs(seen, snap.log_count)) std::cout << line << "\n";
+            seen = std::max<size_t>(seen, snap.log_count);
+            if (snap.finished) {
+                std::cout << "Finished! (press Enter to return)\n";
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(Scheduler::TICK_MS));
+        }
+    });
+
+    std::string line;
+    std::getline(std::cin, line);
+    stop.store(true, std::memory_order_relaxed);
+    follower.join();
+}
+
 bool ScreenManager::attachToProcess(const std::string& name) {
+    std::unique_lock<std::mutex> lock(global_processes_mtx);
     auto it = std::find_if(global_processes.begin(), global_processes.end(),
-        [&](const Process& p) {
-            return p.getName() == name && !p.isFinished();
+        [&](const Process* p) {
+            return p->getName() == name && !p->isFinished();
         });
     size_t procID = std::distance(global_processes.begin(), it) + 1;
 
@@ -212,34 +287,21 @@ bool ScreenManager::attachToProcess(const std::string& name) {
         std::cout << "Process " << name << " not found.\n";
         return false;
     }
+    Process& proc = **it;
+    lock.unlock();
 
     std::string cmd;
     while (true) {
-        std::cout << it->getName() << ":> ";
+        std::cout << proc.getName() << ":> ";
         std::getline(std::cin, cmd);
         if (cmd == "exit") {
             break;
         }
         else if (cmd == "process-smi") {
-            std::cout << "\nProcess name: " << it->getName() << "\n";
-            std::cout << "ID: " << procID << "\n";
-            std::cout << "Logs:\n";
-
-            const auto& logs = it->getLogs(); 
-            if (logs.empty()) {
-                std::cout << "(No logs yet)\n";
-            }
-            else {
-                for (const auto& log : logs) {
-                    std::cout << log << "\n";
-                }
-            }
-
-            std::cout << "Current instruction line: " << it->getCurrentLine() << "\n";
-            std::cout << "Lines of code: " << it->getTotalLines() << "\n";
-            if (!it->isFinished()) {
-                it->executeNextInstruction();
-            }
+            printProcessSmi(proc, procID);
+        }
+        else if (cmd == "tail") {
+            followLogs(proc);
         }
         else {
             std::cout << "Unknown command in screen.\n";
@@ -249,44 +311,49 @@ bool ScreenManager::attachToProcess(const std::string& name) {
 }
 
 void ScreenManager::printUtilizationReport(bool toFile) {
-    std::ostream* outStream;
-    std::ofstream file;
     if (toFile) {
-        file.open("csopesy-log.txt", std::ios::out);
-        if (!file.is_open()) {
-            std::cout << "Error: Cannot open csopesy-log.txt for writing.\n";
-            return;
+        {
+            std::lock_guard<std::mutex> lock(global_processes_mtx);
+            utilizationLog.collect(global_processes, global_processes_generation);
         }
-        outStream = &file;
-    }
-    else {
-        outStream = &std::cout;
+        if (utilizationLog.flush()) {
+            std::cout << "CPU utilization report appended to " << utilizationLog.getPath() << " ("
+                << utilizationLog.getChangedRows() << " changed processes)\n";
+        }
+        return;
     }
+    std::ostream* outStream = &std::cout;
 
+    std::lock_guard<std::mutex> lock(global_processes_mtx);
     int totalCores = Config::getNumCpu(); // Assuming Config has this
     int running = 0;
     int finished = 0;
 
-    for (const auto& p : global_processes) {
-        if (p.isFinished()) finished++;
+    // one snapshot per process, so both lists agree with the counts
+    std::vector<ProcessSnapshot> snaps;
+    snaps.reserve(global_processes.size());
+    for (const Process* p : global_processes) {
+        snaps.push_back(p->snapshot());
+        if (snaps.back().finished) finished++;
         else running++;
     }
 
-    int usedCores = std::min(running, totalCores);
+    int usedCores = std::min(Scheduler::getBusyCores(), totalCores);
     double utilization = (totalCores > 0) ? (100.0 * usedCores / totalCores) : 0.0;
 
     (*outStream) << "===== CPU Utilization Report =====\n";
     (*outStream) << "Cores used: " << usedCores << " / " << totalCores << "\n";
     (*outStream) << std::fixed << std::setprecision(2)
-        << "CPU Utilization: " << utilization << "%\n\n";
+        << "CPU Utilization: " << utilization << "%\n";
+    (*outStream) << "Current tick: " << Scheduler::getCurrentTick() << "\n\n";
 
     (*outStream) << "Running Processes:\n";
     bool hasRunning = false;
     for (size_t i = 0; i < global_processes.size(); ++i) {
-        const auto& p = global_processes[i];
-        if (!p.isFinished()) {
-            (*outStream) << "  " << p.getName() << " (ID " << i + 1 << ") - Line "
-                << p.getCurrentLine() << " / " << p.getTotalLines() << "\n";
+        const ProcessSnapshot& snap = snaps[i];
+        if (!snap.finished) {
+            (*outStream) << "  " << global_processes[i]->getName() << " (ID " << i + 1 << ") - Line "
+                << snap.current_line << " / " << snap.total_lines << "\n";
             hasRunning = true;
         }
     }
@@ -295,19 +362,24 @@ void ScreenManager::printUtilizationReport(bool toFile) {
     (*outStream) << "\nFinished Processes:\n";
     bool hasFinished = false;
     for (size_t i = 0; i < global_processes.size(); ++i) {
-        const auto& p = global_processes[i];
-        if (p.isFinished()) {
-            (*outStream) << "  " << p.getName() << " (ID " << i + 1 << ") - Line "
-                << p.getCurrentLine() << " / " << p.getTotalLines() << "\n";
+        const ProcessSnapshot& snap = snaps[i];
+        if (snap.finished) {
+            (*outStream) << "  " << global_processes[i]->getName() << " (ID " << i + 1 << ") - Line "
+                << snap.current_line << " / " << snap.total_lines << "\n";
             hasFinished = true;
         }
     }
     if (!hasFinished) (*outStream) << "  None\n";
 
+    (*outStream) << "\nLive processes: " << Scheduler::getLiveProcesses();
+    if (Config::getMaxLiveProcesses() > 0) (*outStream) << " / " << Config::getMaxLiveProcesses();
+    (*outStream) << " (" << Scheduler::getPausedArrivals() << " arrivals paused)\n";
+    (*outStream) << "Generator queue: " << ProcessGenerator::getQueueDepth() << " / "
+        << ProcessGenerator::getQueueCapacity() << " (" << ProcessGenerator::getProducerStalls()
+        << " producer stalls)\n";
+    // averages cover processes finished since the policy was loaded
+    (*outStream) << "Policy " << Config::getScheduler() << ": " << Scheduler::getFinishedCount()
+        << " finished, avg waiting " << Scheduler::getAvgWaitingTicks()
+        << " ticks, avg turnaround " << Scheduler::getAvgTurnaroundTicks() << " ticks\n";
     (*outStream) << "==================================\n";
-
-    if (toFile) {
-        file.close();
-        std::cout << "CPU utilization report saved to csopesy-log.txt\n";
-    }
 }
@@ -3,13 +3,15 @@
 #include <vector>
 #include "Process.h"
 
+Process* getProcessByName(const std::string& name); // unfinished processes only
 
 class ScreenManager {
 public:
     static void listProcesses();
     static bool attachToProcess(const std::string& name);
     static void createAndAttach(const std::string& name); 
-    static void addProcess(const Process& p);
-    static std::vector<Process>& getProcesses();
+    static void addProcess(Process* p);
+    static std::vector<Process*>& getProcesses();
+    static void replaceProcesses(std::vector<Process*> processes); // scheduler stopped; frees the old ones
     void printUtilizationReport(bool toFile);
 };
@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single-writer sequence lock. The writer never waits; readers copy the value and
+// retry if a write overlapped. The payload is stored as relaxed atomic words, so a
+// torn read is detected instead of being a data race.
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock payload must be trivially copyable");
+
+public:
+    Seqlock() {
+        for (auto& w : words) w.store(0, std::memory_order_relaxed);
+    }
+
+    void store(const T& value) {
+        uint64_t buf[WORDS] = {};
+        std::memcpy(buf, &value, sizeof(T));
+
+        uint64_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i) words[i].store(buf[i], std::memory_order_relaxed);
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    T load() const {
+        uint64_t buf[WORDS];
+        while (true) {
+            uint64_t s1 = seq.load(std::memory_order_acquire);
+            if (s1 & 1) continue; // write in progress
+            for (size_t i = 0; i < WORDS; ++i) buf[i] = words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == s1) break;
+        }
+        T out;
+        std::memcpy(&out, buf, sizeof(T));
+        return out;
+    }
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> seq{ 0 };
+    std::atomic<uint64_t> words[WORDS];
+};
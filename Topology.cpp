@@ -0,0 +1,270 @@
+#include "Topology.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <tuple>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+namespace {
+#ifndef _WIN32
+    const std::string SYSFS_CPU = "/sys/devices/system/cpu/cpu";
+
+    bool readLine(const std::string& path, std::string& out) {
+        std::ifstream in(path);
+        return static_cast<bool>(std::getline(in, out));
+    }
+
+    int readInt(const std::string& path, int fallback) {
+        std::string line;
+        if (!readLine(path, line)) return fallback;
+        try {
+            return std::stoi(line);
+        }
+        catch (...) {
+            return fallback;
+        }
+    }
+
+    // Lowest CPU in a sysfs cpulist file, -1 if it cannot be read.
+    int firstOfList(const std::string& path) {
+        std::string line;
+        std::vector<int> cpus;
+        if (!readLine(path, line) || !Topology::parseCpuList(line, cpus) || cpus.empty()) return -1;
+        return *std::min_element(cpus.begin(), cpus.end());
+    }
+
+    HostCpu readCpu(int id) {
+        std::string dir = SYSFS_CPU + std::to_string(id);
+        HostCpu cpu{ id, id, 0, -1, -1 };
+        cpu.package = std::max(0, readInt(dir + "/topology/physical_package_id", 0));
+        int core = firstOfList(dir + "/topology/core_cpus_list");
+        if (core < 0) core = firstOfList(dir + "/topology/thread_siblings_list");
+        if (core >= 0) cpu.core = core;
+
+        int topLevel = 0;
+        for (int index = 0; ; ++index) {
+            std::string cache = dir + "/cache/index" + std::to_string(index);
+            int level = readInt(cache + "/level", -1);
+            if (level < 0) break;
+            std::string type;
+            if (readLine(cache + "/type", type) && type == "Instruction") continue;
+            int shared = firstOfList(cache + "/shared_cpu_list");
+            if (shared < 0) continue;
+            if (level == 2) cpu.l2 = shared;
+            if (level >= topLevel) {
+                topLevel = level;
+                cpu.llc = shared;
+            }
+        }
+        return cpu;
+    }
+#endif
+
+    std::vector<HostCpu> readHost() {
+        std::vector<HostCpu> cpus;
+#ifdef _WIN32
+        // no cache information here; one flat package
+        unsigned n = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < n && i < 64; ++i) {
+            int id = static_cast<int>(i);
+            cpus.push_back({ id, id, 0, -1, -1 });
+        }
+#else
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+            unsigned n = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned i = 0; i < n; ++i) CPU_SET(i, &allowed);
+        }
+        for (int i = 0; i < CPU_SETSIZE; ++i) {
+            if (CPU_ISSET(i, &allowed)) cpus.push_back(readCpu(i));
+        }
+#endif
+        return cpus;
+    }
+
+    // Siblings and shared caches next to each other.
+    std::vector<int> compactOrder(const std::vector<HostCpu>& cpus) {
+        std::vector<HostCpu> sorted = cpus;
+        std::sort(sorted.begin(), sorted.end(), [](const HostCpu& a, const HostCpu& b) {
+            return std::tie(a.package, a.llc, a.l2, a.core, a.id) < std::tie(b.package, b.llc, b.l2, b.core, b.id);
+        });
+        std::vector<int> order;
+        for (const HostCpu& c : sorted) order.push_back(c.id);
+        return order;
+    }
+
+    // One thread of every physical core before any second thread; within a pass the
+    // last-level cache domains take turns, alternating packages.
+    std::vector<int> scatterOrder(const std::vector<HostCpu>& cpus) {
+        std::vector<int> compact = compactOrder(cpus);
+        std::map<int, int> smtRank;                            // cpu -> index among its core's threads
+        std::map<int, int> seen;                               // core -> threads ranked so far
+        std::map<std::pair<int, int>, std::vector<int>> domains; // (package, llc) -> cpus, compact order
+        std::map<int, const HostCpu*> byId;
+        for (const HostCpu& c : cpus) byId[c.id] = &c;
+        for (int id : compact) {
+            const HostCpu& c = *byId[id];
+            smtRank[id] = seen[c.core]++;
+            domains[{ c.package, c.llc }].push_back(id);
+        }
+        // domain k of every package before domain k + 1 of any
+        std::map<int, int> perPackage;
+        std::vector<std::pair<std::pair<int, int>, const std::vector<int>*>> turns;
+        for (const auto& [key, list] : domains) turns.push_back({ { perPackage[key.first]++, key.first }, &list });
+        std::sort(turns.begin(), turns.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        std::vector<int> order;
+        int maxRank = 0;
+        for (const auto& [id, rank] : smtRank) maxRank = std::max(maxRank, rank);
+        for (int rank = 0; rank <= maxRank; ++rank) {
+            std::vector<std::vector<int>> lanes;
+            for (const auto& turn : turns) {
+                std::vector<int> lane;
+                for (int id : *turn.second) {
+                    if (smtRank[id] == rank) lane.push_back(id);
+                }
+                lanes.push_back(std::move(lane));
+            }
+            for (size_t i = 0; ; ++i) {
+                bool any = false;
+                for (const auto& lane : lanes) {
+                    if (i < lane.size()) {
+                        order.push_back(lane[i]);
+                        any = true;
+                    }
+                }
+                if (!any) break;
+            }
+        }
+        return order;
+    }
+}
+
+const std::vector<HostCpu>& Topology::host() {
+    static const std::vector<HostCpu> cpus = readHost();
+    return cpus;
+}
+
+const HostCpu* Topology::find(int cpu) {
+    for (const HostCpu& c : host()) {
+        if (c.id == cpu) return &c;
+    }
+    return nullptr;
+}
+
+std::vector<int> Topology::placement(const std::string& mode, const std::vector<int>& list, int cores) {
+    std::vector<int> sequence;
+    if (mode == "compact") sequence = compactOrder(host());
+    else if (mode == "scatter") sequence = scatterOrder(host());
+    else if (mode == "list") sequence = list;
+    std::vector<int> out(static_cast<size_t>(std::max(cores, 0)), -1);
+    if (sequence.empty()) return out;
+    for (size_t i = 0; i < out.size(); ++i) out[i] = sequence[i % sequence.size()];
+    return out;
+}
+
+int Topology::distance(int a, int b) {
+    if (a == b) return 0;
+    const HostCpu* x = find(a);
+    const HostCpu* y = find(b);
+    if (!x || !y || x->package != y->package) return 5;
+    if (x->core == y->core) return 1;
+    if (x->l2 >= 0 && x->l2 == y->l2) return 2;
+    if (x->llc >= 0 && x->llc == y->llc) return 3;
+    return 4;
+}
+
+std::vector<std::vector<int>> Topology::stealOrder(const std::vector<int>& placement) {
+    std::vector<std::vector<int>> orders;
+    int n = static_cast<int>(placement.size());
+    if (std::find(placement.begin(), placement.end(), -1) != placement.end()) return orders;
+    for (int self = 0; self < n; ++self) {
+        std::vector<int> others;
+        for (int i = 1; i < n; ++i) others.push_back((self + i) % n);
+        std::stable_sort(others.begin(), others.end(), [&](int a, int b) {
+            return distance(placement[self], placement[a]) < distance(placement[self], placement[b]);
+        });
+        orders.push_back(std::move(others));
+    }
+    return orders;
+}
+
+bool Topology::pinCurrentThread(int cpu) {
+#ifdef _WIN32
+    if (cpu < 0 || cpu >= 64) return false;
+    return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu) != 0;
+#else
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0; // 0: the calling thread
+#endif
+}
+
+bool Topology::parseCpuList(const std::string& text, std::vector<int>& out) {
+    out.clear();
+    if (!text.empty() && text.back() == ',') return false; // the loop below never sees the empty last item
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find(',', pos);
+        if (end == std::string::npos) end = text.size();
+        std::string item = text.substr(pos, end - pos);
+        pos = end + 1;
+        if (item.empty()) return false;
+        size_t dash = item.find('-');
+        try {
+            size_t used = 0;
+            int first = std::stoi(item.substr(0, dash), &used);
+            if (used != (dash == std::string::npos ? item.size() : dash)) return false;
+            int last = first;
+            if (dash != std::string::npos) {
+                std::string tail = item.substr(dash + 1);
+                last = std::stoi(tail, &used);
+                if (used != tail.size()) return false;
+            }
+            if (first < 0 || last < first || last >= 1024) return false;
+            for (int c = first; c <= last; ++c) out.push_back(c);
+        }
+        catch (...) {
+            return false;
+        }
+    }
+    return !out.empty();
+}
+
+void Topology::print(const std::vector<int>& placement, const std::vector<bool>& pinned) {
+    std::cout << "===== Host CPU Topology =====\n";
+    std::cout << "  " << std::left << std::setw(6) << "cpu" << std::right << std::setw(6) << "core"
+        << std::setw(9) << "package" << std::setw(6) << "l2" << std::setw(6) << "llc" << "   emulated cores\n";
+    auto group = [](int g) { return g < 0 ? std::string("-") : std::to_string(g); };
+    for (const HostCpu& c : host()) {
+        std::cout << "  " << std::left << std::setw(6) << c.id << std::right << std::setw(6) << c.core
+            << std::setw(9) << c.package << std::setw(6) << group(c.l2) << std::setw(6) << group(c.llc) << "   ";
+        bool any = false;
+        for (size_t i = 0; i < placement.size(); ++i) {
+            if (placement[i] != c.id) continue;
+            std::cout << (any ? ", " : "") << i << (i < pinned.size() && pinned[i] ? "" : " (not pinned)");
+            any = true;
+        }
+        std::cout << "\n";
+    }
+    for (size_t i = 0; i < placement.size(); ++i) {
+        if (placement[i] >= 0 && !find(placement[i])) {
+            std::cout << "  core " << i << " -> cpu " << placement[i] << " is not available to this process\n";
+        }
+    }
+    if (placement.empty() || placement.front() < 0) std::cout << "  Emulated cores are not pinned (cpu-affinity off).\n";
+    std::cout << "=============================\n";
+}
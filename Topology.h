@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// A logical CPU of the host and what it shares with the others. Groups are named by
+// the lowest CPU id in them; -1 when the host does not say.
+struct HostCpu {
+    int id;
+    int core;    // SMT siblings share it
+    int package;
+    int l2;
+    int llc;     // last-level cache
+};
+
+// Host CPU topology and pinning of the emulated cores' threads. On Linux it is read
+// from sysfs and threads pin themselves with sched_setaffinity; elsewhere the CPUs
+// are treated as one flat package.
+//
+// A placement maps each emulated core to a host CPU. compact fills SMT siblings and
+// shared caches first, scatter spreads over packages, caches and physical cores
+// before it doubles up, and a list from config.txt is used as given. Core i always
+// gets entry i of the sequence (wrapping), so adding cores never moves existing ones.
+class Topology {
+public:
+    static const std::vector<HostCpu>& host(); // the CPUs this process may run on; read once
+
+    static std::vector<int> placement(const std::string& mode, const std::vector<int>& list, int cores); // -1 = not pinned
+    static int distance(int a, int b); // 0 same CPU, 1 SMT sibling, 2 shared L2, 3 shared LLC, 4 same package, 5 apart
+    // For each emulated core, the other cores nearest first (ties in ring order); empty when not pinned.
+    static std::vector<std::vector<int>> stealOrder(const std::vector<int>& placement);
+
+    static bool pinCurrentThread(int cpu);
+    static bool parseCpuList(const std::string& text, std::vector<int>& out); // "0,2,4-7"
+    static void print(const std::vector<int>& placement, const std::vector<bool>& pinned);
+
+private:
+    static const HostCpu* find(int cpu);
+};
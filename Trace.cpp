@@ -0,0 +1,521 @@
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include "Config.h"
+#include "Scheduler.h"
+#include "ScreenManager.h"
+
+// File layout (native little-endian; strings are a u16 length and the bytes):
+//   header  magic[8] "CSTRACE\n", u32 version, u32 cores, u64 start tick,
+//           u64 end tick (patched by stop), u32 first pid, u64 streams generated
+//           before the start, u64 live processes, u32 seed, scheduler name,
+//           u32 + (key, value) settings
+//   chunks  until the end of the file: i16 source, u32 count, count TraceRecords
+// A source's chunks are in order; load() merges the sources by tick.
+
+std::ofstream Trace::out;
+std::string Trace::outPath;
+std::vector<TraceBuffer> Trace::buffers;
+std::thread Trace::writer;
+std::mutex Trace::mtx;
+std::condition_variable Trace::ready;
+std::deque<std::pair<int16_t, std::vector<TraceRecord>>> Trace::pending;
+std::vector<std::vector<TraceRecord>> Trace::spare;
+bool Trace::stopping = false;
+uint64_t Trace::written = 0;
+
+static_assert(sizeof(TraceRecord) == 24, "trace records are written as they are laid out");
+
+namespace {
+    constexpr char MAGIC[8] = { 'C', 'S', 'T', 'R', 'A', 'C', 'E', '\n' };
+    constexpr size_t END_TICK_OFFSET = 8 + 4 + 4 + 8;
+
+    template <class T> void put(std::ofstream& out, T v) {
+        out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+
+    void putStr(std::ofstream& out, const std::string& s) {
+        put<uint16_t>(out, static_cast<uint16_t>(s.size()));
+        out.write(s.data(), static_cast<std::streamsize>(s.size()));
+    }
+
+    class Reader {
+    public:
+        Reader(const char* p, size_t n) : p(p), end(p + n) {}
+
+        template <class T> T get() {
+            need(sizeof(T));
+            T v;
+            std::memcpy(&v, p, sizeof(T));
+            p += sizeof(T);
+            return v;
+        }
+        const char* bytes(size_t n) {
+            need(n);
+            const char* at = p;
+            p += n;
+            return at;
+        }
+        std::string str() {
+            uint16_t n = get<uint16_t>();
+            return std::string(bytes(n), n);
+        }
+        size_t left() const { return static_cast<size_t>(end - p); }
+
+    private:
+        const char* p;
+        const char* end;
+
+        void need(size_t n) const {
+            if (left() < n) throw std::runtime_error("file is truncated");
+        }
+    };
+
+    // Order of events within a tick: arrivals and wake-ups, then dispatch, then what
+    // each core's cycle ended in.
+    int phase(TraceEvent type) {
+        switch (type) {
+        case TraceEvent::ARRIVE:
+        case TraceEvent::WAKE:
+            return 0;
+        case TraceEvent::DISPATCH:
+            return 1;
+        default:
+            return 2;
+        }
+    }
+
+    const char* eventName(TraceEvent type) {
+        switch (type) {
+        case TraceEvent::ARRIVE: return "ARRIVE";
+        case TraceEvent::WAKE: return "WAKE";
+        case TraceEvent::DISPATCH: return "DISPATCH";
+        case TraceEvent::PREEMPT: return "PREEMPT";
+        case TraceEvent::SLEEP: return "SLEEP";
+        case TraceEvent::FINISH: return "FINISH";
+        }
+        return "?";
+    }
+
+    std::string describe(const TraceRecord& r) {
+        std::string s = "tick " + std::to_string(r.tick) + " " + eventName(r.type) + " " + Scheduler::processName(r.pid);
+        if (r.core >= 0) s += " on core " + std::to_string(r.core);
+        if (r.type == TraceEvent::ARRIVE) s += " (" + std::to_string(r.arg) + " lines)";
+        if (r.type == TraceEvent::DISPATCH) s += " (budget " + std::to_string(r.arg) + ")";
+        if (r.type == TraceEvent::SLEEP) s += " (" + std::to_string(r.arg) + " ticks)";
+        return s;
+    }
+
+    bool sameEvent(const TraceRecord& a, const TraceRecord& b) {
+        return a.tick == b.tick && a.type == b.type && a.core == b.core && a.pid == b.pid && a.arg == b.arg;
+    }
+
+    char pidSymbol(uint32_t pid) {
+        static const char* digits = "0123456789abcdefghijklmnopqrstuvwxyz";
+        return digits[pid % 36];
+    }
+}
+
+// ---------- recording ----------
+
+void TraceBuffer::add(TraceEvent type, uint64_t tick, int core, uint32_t pid, int64_t arg) {
+    records.push_back({ tick, arg, pid, static_cast<int16_t>(core), type, 0 });
+    if (records.size() == CHUNK) Trace::submit(*this);
+}
+
+TraceHeader TraceHeader::fromConfig() {
+    TraceHeader h;
+    h.settings = {
+        { "num-cpu", std::to_string(Config::getNumCpu()) },
+        { "min-ins", std::to_string(Config::getMinIns()) },
+        { "max-ins", std::to_string(Config::getMaxIns()) },
+        { "delay-per-exec", std::to_string(Config::getDelayPerExec()) },
+        { "max-overall-mem", std::to_string(Config::getMaxOverallMem()) },
+        { "mem-per-frame", std::to_string(Config::getMemPerFrame()) },
+        { "min-mem-per-proc", std::to_string(Config::getMinMemPerProc()) },
+        { "max-mem-per-proc", std::to_string(Config::getMaxMemPerProc()) },
+        { "page-replacement", Config::getPageReplacement() },
+    };
+    return h;
+}
+
+bool Trace::start(const std::string& path, const TraceHeader& header) {
+    if (isRecording()) stop(header.startTick);
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Error: Cannot write trace '" << path << "'\n";
+        return false;
+    }
+    outPath = path;
+    out.write(MAGIC, sizeof(MAGIC));
+    put<uint32_t>(out, VERSION);
+    put<uint32_t>(out, header.cores);
+    put<uint64_t>(out, header.startTick);
+    put<uint64_t>(out, 0); // end tick
+    put<uint32_t>(out, header.firstPid);
+    put<uint64_t>(out, header.generated);
+    put<uint64_t>(out, header.live);
+    put<uint32_t>(out, header.seed);
+    putStr(out, header.scheduler);
+    put<uint32_t>(out, static_cast<uint32_t>(header.settings.size()));
+    for (const auto& [key, value] : header.settings) {
+        putStr(out, key);
+        putStr(out, value);
+    }
+
+    buffers.assign(header.cores + 1, TraceBuffer{});
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        buffers[i].source = static_cast<int16_t>(i);
+        buffers[i].records.reserve(TraceBuffer::CHUNK);
+    }
+    stopping = false;
+    written = 0;
+    writer = std::thread(&Trace::writerLoop);
+    return true;
+}
+
+void Trace::stop(uint64_t endTick) {
+    if (!isRecording()) return;
+    for (TraceBuffer& b : buffers) {
+        if (!b.records.empty()) submit(b);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    ready.notify_all();
+    writer.join();
+    buffers.clear();
+    spare.clear();
+
+    out.seekp(END_TICK_OFFSET);
+    put<uint64_t>(out, endTick);
+    out.close();
+    if (!out) std::cerr << "Error: Writing trace '" << outPath << "' failed.\n";
+    else std::cout << "Trace written to " << outPath << " (" << written << " events, up to tick " << endTick << ")\n";
+}
+
+TraceBuffer* Trace::buffer(int source) {
+    return isRecording() ? &buffers[source] : nullptr;
+}
+
+// Hands a chunk to the writer thread and gives the buffer an empty one. Taken once
+// per CHUNK events, so the lock stays off the per-event path.
+void Trace::submit(TraceBuffer& b) {
+    std::vector<TraceRecord> next;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending.emplace_back(b.source, std::move(b.records));
+        if (!spare.empty()) {
+            next = std::move(spare.back());
+            spare.pop_back();
+        }
+    }
+    ready.notify_one();
+    if (next.capacity() == 0) next.reserve(TraceBuffer::CHUNK);
+    b.records = std::move(next);
+}
+
+void Trace::writerLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        ready.wait(lock, [] { return !pending.empty() || stopping; });
+        if (pending.empty()) break;
+        auto [source, records] = std::move(pending.front());
+        pending.pop_front();
+        lock.unlock();
+        put<int16_t>(out, source);
+        put<uint32_t>(out, static_cast<uint32_t>(records.size()));
+        out.write(reinterpret_cast<const char*>(records.data()),
+            static_cast<std::streamsize>(records.size() * sizeof(TraceRecord)));
+        written += records.size();
+        records.clear();
+        lock.lock();
+        spare.push_back(std::move(records));
+    }
+}
+
+// ---------- offline ----------
+
+bool Trace::load(const std::string& path, TraceHeader& header, std::vector<TraceRecord>& records) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        std::cerr << "Error: Cannot open trace '" << path << "'\n";
+        return false;
+    }
+    std::vector<char> data(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(data.data(), static_cast<std::streamsize>(data.size()));
+
+    records.clear();
+    try {
+        Reader r(data.data(), data.size());
+        if (std::memcmp(r.bytes(sizeof(MAGIC)), MAGIC, sizeof(MAGIC)) != 0) {
+            throw std::runtime_error("not a trace file");
+        }
+        uint32_t version = r.get<uint32_t>();
+        if (version != VERSION) throw std::runtime_error("unsupported version " + std::to_string(version));
+        header.cores = r.get<uint32_t>();
+        header.startTick = r.get<uint64_t>();
+        header.endTick = r.get<uint64_t>();
+        header.firstPid = r.get<uint32_t>();
+        header.generated = r.get<uint64_t>();
+        header.live = r.get<uint64_t>();
+        header.seed = r.get<uint32_t>();
+        header.scheduler = r.str();
+        header.settings.resize(r.get<uint32_t>());
+        for (auto& [key, value] : header.settings) {
+            key = r.str();
+            value = r.str();
+        }
+
+        while (r.left() > 0) {
+            int16_t source = r.get<int16_t>();
+            uint32_t count = r.get<uint32_t>();
+            if (source < 0 || static_cast<uint32_t>(source) > header.cores) throw std::runtime_error("bad chunk");
+            const char* at = r.bytes(static_cast<size_t>(count) * sizeof(TraceRecord));
+            size_t first = records.size();
+            records.resize(first + count);
+            std::memcpy(&records[first], at, static_cast<size_t>(count) * sizeof(TraceRecord));
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: Cannot read trace '" << path << "': " << e.what() << "\n";
+        return false;
+    }
+
+    // a source's events are already in order, so a stable sort merges the sources
+    std::stable_sort(records.begin(), records.end(), [](const TraceRecord& a, const TraceRecord& b) {
+        if (a.tick != b.tick) return a.tick < b.tick;
+        int pa = phase(a.type), pb = phase(b.type);
+        if (pa != pb) return pa < pb;
+        return a.core < b.core;
+    });
+    if (header.endTick == 0) { // recording never stopped
+        header.endTick = records.empty() ? header.startTick : records.back().tick;
+        std::cout << "Warning: trace '" << path << "' was not closed; reading up to tick " << header.endTick << ".\n";
+    }
+    return true;
+}
+
+bool Trace::compare(const std::string& expected, const std::string& actual) {
+    TraceHeader ha, hb;
+    std::vector<TraceRecord> a, b;
+    if (!load(expected, ha, a) || !load(actual, hb, b)) return false;
+
+    size_t n = std::min(a.size(), b.size());
+    size_t i = 0;
+    while (i < n && sameEvent(a[i], b[i])) ++i;
+    if (i == a.size() && i == b.size()) {
+        std::cout << "Replay matches the recording: " << a.size() << " events, ticks "
+            << ha.startTick + 1 << "-" << ha.endTick << ".\n";
+        return true;
+    }
+    std::cout << "Replay diverged after " << i << " matching events.\n";
+    std::cout << "  recorded: " << (i < a.size() ? describe(a[i]) : "end of trace") << "\n";
+    std::cout << "  replayed: " << (i < b.size() ? describe(b[i]) : "end of trace") << "\n";
+    return false;
+}
+
+bool Trace::analyze(const std::string& path, const std::string& csvPrefix) {
+    TraceHeader h;
+    std::vector<TraceRecord> records;
+    if (!load(path, h, records)) return false;
+
+    struct Proc {
+        uint64_t arrival = UINT64_MAX;
+        uint64_t finish = UINT64_MAX;
+        uint64_t readySince = UINT64_MAX; // unknown until we see it become ready
+        uint64_t waiting = 0;
+        uint32_t dispatches = 0;
+    };
+    struct Segment {
+        uint32_t pid;
+        uint64_t start;
+        uint64_t end; // inclusive
+    };
+
+    uint32_t maxPid = 0;
+    for (const TraceRecord& r : records) maxPid = std::max(maxPid, r.pid);
+    std::vector<Proc> procs(static_cast<size_t>(maxPid) + 1);
+    std::vector<bool> seen(procs.size(), false);
+    std::vector<std::vector<Segment>> gantt(h.cores);
+    std::vector<int64_t> open(h.cores, -1); // index of the core's running segment
+
+    for (const TraceRecord& r : records) {
+        Proc& p = procs[r.pid];
+        seen[r.pid] = true;
+        bool onCore = r.core >= 0 && static_cast<uint32_t>(r.core) < h.cores;
+        switch (r.type) {
+        case TraceEvent::ARRIVE:
+            p.arrival = r.tick;
+            p.readySince = r.tick;
+            break;
+        case TraceEvent::WAKE:
+            p.readySince = r.tick;
+            break;
+        case TraceEvent::DISPATCH:
+            if (p.readySince != UINT64_MAX) p.waiting += r.tick - p.readySince;
+            p.readySince = UINT64_MAX;
+            p.dispatches++;
+            if (onCore) {
+                open[r.core] = static_cast<int64_t>(gantt[r.core].size());
+                gantt[r.core].push_back({ r.pid, r.tick, h.endTick });
+            }
+            break;
+        case TraceEvent::PREEMPT:
+        case TraceEvent::SLEEP:
+        case TraceEvent::FINISH:
+            if (r.type == TraceEvent::PREEMPT) p.readySince = r.tick + 1; // waits from the next tick
+            if (r.type == TraceEvent::FINISH) p.finish = r.tick;
+            if (!onCore) break;
+            if (open[r.core] >= 0) gantt[r.core][open[r.core]].end = r.tick;
+            else gantt[r.core].push_back({ r.pid, h.startTick + 1, r.tick }); // was running when the trace started
+            open[r.core] = -1;
+            break;
+        }
+    }
+
+    // the same figures the scheduler keeps, over processes whose whole life is in the trace
+    uint64_t total = 0, finished = 0, waitSum = 0, turnSum = 0, maxWait = 0;
+    uint32_t maxWaitPid = 0;
+    for (uint32_t pid = 0; pid < procs.size(); ++pid) {
+        if (!seen[pid]) continue;
+        total++;
+        const Proc& p = procs[pid];
+        if (p.arrival == UINT64_MAX || p.finish == UINT64_MAX) continue;
+        finished++;
+        waitSum += p.waiting;
+        turnSum += p.finish - p.arrival + 1;
+        if (p.waiting >= maxWait) {
+            maxWait = p.waiting;
+            maxWaitPid = pid;
+        }
+    }
+
+    uint64_t span = h.endTick > h.startTick ? h.endTick - h.startTick : 1;
+    std::cout << "===== Trace Analysis =====\n";
+    std::cout << "Trace: " << path << " (" << h.scheduler << ", " << h.cores << " cores, ticks "
+        << h.startTick + 1 << "-" << h.endTick << ", " << records.size() << " events)\n";
+    std::cout << "Processes seen: " << total << ", arrived and finished: " << finished << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    if (finished > 0) {
+        std::cout << "Avg waiting ticks: " << static_cast<double>(waitSum) / finished << "\n";
+        std::cout << "Avg turnaround ticks: " << static_cast<double>(turnSum) / finished << "\n";
+        std::cout << "Longest wait: " << Scheduler::processName(maxWaitPid) << " (" << maxWait << " ticks)\n";
+    }
+
+    // one column per bucket of ticks: the process that held the core longest in it,
+    // or '.' when the core was idle for most of it
+    constexpr uint64_t COLUMNS = 64;
+    uint64_t width = (span + COLUMNS - 1) / COLUMNS;
+    uint64_t columns = (span + width - 1) / width;
+    std::cout << "Gantt chart, " << width << " tick(s) per column (symbol = pid mod 36):\n";
+    for (uint32_t c = 0; c < h.cores; ++c) {
+        std::vector<uint64_t> busy(columns, 0), best(columns, 0);
+        std::string row(columns, '.');
+        uint64_t busyTicks = 0;
+        for (const Segment& s : gantt[c]) {
+            busyTicks += s.end - s.start + 1;
+            for (uint64_t t = s.start; t <= s.end;) {
+                uint64_t col = (t - h.startTick - 1) / width;
+                if (col >= columns) break;
+                uint64_t colEnd = h.startTick + (col + 1) * width;
+                uint64_t overlap = std::min(s.end, colEnd) - t + 1;
+                busy[col] += overlap;
+                if (overlap > best[col]) {
+                    best[col] = overlap;
+                    row[col] = pidSymbol(s.pid);
+                }
+                t += overlap;
+            }
+        }
+        for (uint64_t col = 0; col < columns; ++col) {
+            if (busy[col] * 2 < width) row[col] = '.';
+        }
+        std::cout << "  core " << std::setw(3) << c << " |" << row << "| "
+            << std::setw(6) << 100.0 * busyTicks / span << "%\n";
+    }
+    std::cout << std::defaultfloat;
+    std::cout << "==========================\n";
+
+    if (csvPrefix.empty()) return true;
+    std::ofstream pcsv(csvPrefix + "-processes.csv");
+    std::ofstream gcsv(csvPrefix + "-gantt.csv");
+    if (!pcsv || !gcsv) {
+        std::cerr << "Error: Cannot write '" << csvPrefix << "-*.csv'\n";
+        return false;
+    }
+    pcsv << "pid,name,arrival,finish,waiting,turnaround,dispatches\n";
+    for (uint32_t pid = 0; pid < procs.size(); ++pid) {
+        if (!seen[pid]) continue;
+        const Proc& p = procs[pid];
+        bool whole = p.arrival != UINT64_MAX && p.finish != UINT64_MAX;
+        pcsv << pid << ',' << Scheduler::processName(pid) << ',';
+        if (p.arrival != UINT64_MAX) pcsv << p.arrival;
+        pcsv << ',';
+        if (p.finish != UINT64_MAX) pcsv << p.finish;
+        pcsv << ',' << p.waiting << ',';
+        if (whole) pcsv << p.finish - p.arrival + 1;
+        pcsv << ',' << p.dispatches << '\n';
+    }
+    gcsv << "core,pid,name,start,end\n";
+    for (uint32_t c = 0; c < h.cores; ++c) {
+        for (const Segment& s : gantt[c]) {
+            gcsv << c << ',' << s.pid << ',' << Scheduler::processName(s.pid) << ',' << s.start << ',' << s.end << '\n';
+        }
+    }
+    std::cout << "Wrote " << csvPrefix << "-processes.csv and " << csvPrefix << "-gantt.csv\n";
+    return true;
+}
+
+ReplayResult Trace::replay(const std::string& path) {
+    TraceHeader h;
+    std::vector<TraceRecord> records;
+    if (!load(path, h, records)) return ReplayResult::REJECTED;
+    if (h.generated != 0 || h.live != 0) {
+        std::cout << "Error: The trace started with processes already generated; replay needs one started\n"
+            << "before the first arrival after initialize.\n";
+        return ReplayResult::REJECTED;
+    }
+    TraceHeader now = TraceHeader::fromConfig();
+    bool matches = true;
+    for (const auto& [key, value] : h.settings) {
+        auto it = std::find_if(now.settings.begin(), now.settings.end(), [&](const auto& kv) { return kv.first == key; });
+        std::string current = it != now.settings.end() ? it->second : "(unset)";
+        if (current != value) {
+            std::cout << "Error: " << key << " is " << current << " but the trace was recorded with " << value << ".\n";
+            matches = false;
+        }
+    }
+    if (!matches) return ReplayResult::REJECTED;
+
+    ReplayScript script;
+    script.seed = h.seed;
+    script.startTick = h.startTick;
+    script.endTick = h.endTick;
+    script.firstPid = h.firstPid;
+    for (const TraceRecord& r : records) {
+        if (r.type == TraceEvent::ARRIVE) script.arrivals.push_back(r.tick);
+        else if (r.type == TraceEvent::DISPATCH) script.dispatches.push_back({ r.tick, r.core, r.pid, r.arg });
+    }
+
+    std::string replayPath = path + ".replay";
+    auto start = std::chrono::steady_clock::now();
+    Scheduler::shutdown();
+    ScreenManager::replaceProcesses({});
+    std::future<void> done = Scheduler::replay(std::move(script), replayPath);
+    if (!done.valid()) return ReplayResult::FAILED;
+    done.wait();
+    Scheduler::shutdown();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << "Replayed ticks " << h.startTick + 1 << "-" << h.endTick << " in " << ms.count()
+        << " ms. The scheduler is stopped; run initialize to continue.\n";
+    return compare(path, replayPath) ? ReplayResult::MATCHED : ReplayResult::DIVERGED;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class TraceEvent : uint8_t { ARRIVE, WAKE, DISPATCH, PREEMPT, SLEEP, FINISH };
+
+// One scheduling event. arg is the instruction count for ARRIVE, the budget for
+// DISPATCH and the ticks to sleep for SLEEP.
+struct TraceRecord {
+    uint64_t tick;
+    int64_t arg;
+    uint32_t pid;
+    int16_t core; // -1 for the scheduler's own events
+    TraceEvent type;
+    uint8_t reserved;
+};
+
+// Events of one core (or of the scheduler). It has a single writer at a time, the
+// same as the core's process: the scheduler between ticks, the core during its
+// cycle. A full chunk goes to the trace writer thread.
+class TraceBuffer {
+public:
+    static constexpr size_t CHUNK = 4096;
+
+    void add(TraceEvent type, uint64_t tick, int core, uint32_t pid, int64_t arg = 0);
+
+private:
+    friend class Trace;
+    int16_t source = 0;
+    std::vector<TraceRecord> records;
+};
+
+// What a trace was recorded under. Replay needs the same generated processes, so it
+// checks the settings they depend on and reseeds the generator with the same seed.
+struct TraceHeader {
+    uint32_t cores = 0;
+    uint64_t startTick = 0;
+    uint64_t endTick = 0;   // last tick recorded
+    uint32_t firstPid = 1;  // id the next arrival gets
+    uint64_t generated = 0; // streams taken from the generator before the trace started
+    uint64_t live = 0;      // processes already admitted and unfinished at the start
+    uint32_t seed = 0;
+    std::string scheduler;
+    std::vector<std::pair<std::string, std::string>> settings;
+
+    static TraceHeader fromConfig(); // settings of the loaded config
+};
+
+enum class ReplayResult {
+    REJECTED, // the trace cannot be replayed here; the scheduler was not touched
+    FAILED,   // the replay could not start; the scheduler is shut down
+    DIVERGED, // the scheduler is shut down and the replay differs from the trace
+    MATCHED,  // the scheduler is shut down and the replay matches the trace
+};
+
+// Binary trace of dispatch, preempt, sleep, wake, finish and arrival events. Cores
+// record into their own buffers without locks; a background thread appends full
+// chunks to the file. The offline side loads a trace, compares two, and computes
+// waiting times and a per-core Gantt chart.
+class Trace {
+public:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr const char* DEFAULT_PATH = "csopesy.trace";
+
+    // Scheduler thread, between ticks.
+    static bool start(const std::string& path, const TraceHeader& header);
+    static void stop(uint64_t endTick);
+    static bool isRecording() { return out.is_open(); }
+    static TraceBuffer* buffer(int source); // a core id, or the core count for the scheduler
+
+    // Offline; records come back in execution order.
+    static bool load(const std::string& path, TraceHeader& header, std::vector<TraceRecord>& records);
+    static bool compare(const std::string& expected, const std::string& actual);
+    static bool analyze(const std::string& path, const std::string& csvPrefix);
+    static ReplayResult replay(const std::string& path); // re-runs it and compares
+
+private:
+    friend class TraceBuffer;
+
+    static std::ofstream out;
+    static std::string outPath;
+    static std::vector<TraceBuffer> buffers;
+    static std::thread writer;
+    static std::mutex mtx;
+    static std::condition_variable ready;
+    static std::deque<std::pair<int16_t, std::vector<TraceRecord>>> pending;
+    static std::vector<std::vector<TraceRecord>> spare;
+    static bool stopping;
+    static uint64_t written;
+
+    static void submit(TraceBuffer& b);
+    static void writerLoop();
+};
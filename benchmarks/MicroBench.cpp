@@ -0,0 +1,297 @@
+// Microbenchmarks for the emulator's core subsystems, each measured on its own:
+// instruction execution per opcode, process generation and admission, process-table
+// lookups, config loading, the scheduling policies' ready queues, and the command
+// queue into the scheduler thread under producer contention.
+//
+// Not part of CSOPESY_MCO1.vcxproj. Linux build, from the repository root, linking
+// every translation unit of the emulator except main.cpp:
+//
+//   g++ -std=c++20 -O2 -pthread -I. $(ls *.cpp | grep -v '^main\.cpp$') benchmarks/MicroBench.cpp -o microbench
+//   ./microbench [--filter <substring>] [--scale <factor>] > results.jsonl
+//
+// Output is JSON Lines: a "meta" record, then one record per case with the
+// iteration count, ns per operation and operations per second. Comparing two
+// result files case by case shows regressions between releases. Scratch files
+// (config, backing store) go to the working directory and are removed at the end.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../CommandQueue.h"
+#include "../Config.h"
+#include "../MemoryManager.h"
+#include "../Process.h"
+#include "../ProcessGenerator.h"
+#include "../Scheduler.h"
+#include "../SchedulingPolicy.h"
+#include "../ScreenManager.h"
+
+namespace {
+    constexpr const char* CONFIG_PATH = "microbench-config.txt";
+    constexpr const char* STORE_PATH = "microbench-backing-store.bin";
+
+    std::string filter;
+    double scale = 1.0;
+
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t scaled(uint64_t n) {
+        return std::max<uint64_t>(1, static_cast<uint64_t>(static_cast<double>(n) * scale));
+    }
+
+    bool selected(const std::string& bench) {
+        return filter.empty() || bench.find(filter) != std::string::npos;
+    }
+
+    void report(const std::string& bench, const std::string& name, uint64_t iterations, Clock::duration elapsed) {
+        double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        double perOp = ns / static_cast<double>(iterations);
+        std::printf("{\"bench\":\"%s\",\"case\":\"%s\",\"iterations\":%llu,\"ns_per_op\":%.2f,\"ops_per_sec\":%.0f}\n",
+            bench.c_str(), name.c_str(), static_cast<unsigned long long>(iterations), perOp,
+            perOp > 0 ? 1e9 / perOp : 0.0);
+        std::fflush(stdout);
+    }
+
+    template <class F> Clock::duration timeIt(F&& f) {
+        auto start = Clock::now();
+        f();
+        return Clock::now() - start;
+    }
+
+    bool writeConfig(const std::string& scheduler) {
+        std::ofstream out(CONFIG_PATH, std::ios::trunc);
+        out << "num-cpu 4\n"
+            << "scheduler " << scheduler << "\n"
+            << "quantum-cycles 5\n"
+            << "batch-process-freq 1\n"
+            << "min-ins 100\n"
+            << "max-ins 200\n"
+            << "delay-per-exec 0\n"
+            << "time-mode virtual\n"
+            << "random-seed 42\n"
+            << "max-overall-mem 65536\n"
+            << "mem-per-frame 256\n"
+            << "min-mem-per-proc 4096\n"
+            << "max-mem-per-proc 4096\n"
+            << "backing-store " << STORE_PATH << "\n";
+        out.close();
+        return static_cast<bool>(out) && Config::load(CONFIG_PATH);
+    }
+
+    Instruction make(Instruction::Type type, std::initializer_list<const char*> args) {
+        Instruction instr;
+        instr.type = type;
+        for (const char* a : args) instr.args.emplace_back(a);
+        return instr;
+    }
+
+    // Process::executeInstruction, the path screen -s input takes, one opcode at a time.
+    void benchExecute() {
+        if (!selected("execute")) return;
+        Process* p = Process::create("bench", InstructionList{});
+        MemoryManager::attach(p->getMemory(), static_cast<uint32_t>(Config::getMinMemPerProc()));
+        p->executeInstruction(make(Instruction::DECLARE, { "x", "7" }));
+        p->executeInstruction(make(Instruction::DECLARE, { "y", "3" }));
+
+        struct Case {
+            const char* name;
+            Instruction instr;
+        };
+        std::vector<Case> cases = {
+            { "PRINT", make(Instruction::PRINT, { "\"hello\"" }) },
+            { "DECLARE", make(Instruction::DECLARE, { "z", "42" }) },
+            { "ADD", make(Instruction::ADD, { "z", "x", "y" }) },
+            { "SUBTRACT", make(Instruction::SUBTRACT, { "z", "x", "y" }) },
+            { "SLEEP", make(Instruction::SLEEP, { "0" }) },
+            { "FOR", make(Instruction::FOR, { "ADD", "4", "z", "z", "1" }) },
+            { "WRITE", make(Instruction::WRITE, { "0x40", "123" }) },
+            { "READ", make(Instruction::READ, { "z", "0x40" }) },
+        };
+        uint64_t n = scaled(200000);
+        for (const Case& c : cases) {
+            p->executeInstruction(c.instr); // warm
+            report("execute", c.name, n, timeIt([&] {
+                for (uint64_t i = 0; i < n; ++i) p->executeInstruction(c.instr);
+            }));
+        }
+        MemoryManager::release(p->getMemory());
+        Process::destroy(p);
+    }
+
+    // The generator pipeline on its own, then Scheduler::createDummyProcess on top of it
+    // (naming, the process table and the admission queue).
+    void benchGenerate() {
+        if (!selected("generate")) return;
+        uint64_t n = scaled(20000);
+        std::vector<Process*> made;
+        made.reserve(n);
+        ProcessGenerator::start(42);
+        report("generate", "ProcessGenerator::next", n, timeIt([&] {
+            for (uint64_t i = 0; i < n; ++i) made.push_back(ProcessGenerator::next("g" + std::to_string(i)));
+        }));
+        for (Process* p : made) {
+            MemoryManager::release(p->getMemory());
+            Process::destroy(p);
+        }
+
+        ProcessGenerator::start(42);
+        report("generate", "Scheduler::createDummyProcess", n, timeIt([&] {
+            for (uint64_t i = 0; i < n; ++i) Scheduler::createDummyProcess();
+        }));
+        ProcessGenerator::stop();
+    }
+
+    // getProcessByName over the table createDummyProcess filled.
+    void benchLookup() {
+        if (!selected("lookup")) return;
+        size_t tableSize = ScreenManager::getProcesses().size();
+        if (tableSize == 0) {
+            ProcessGenerator::start(42);
+            for (uint64_t i = 0; i < scaled(20000); ++i) Scheduler::createDummyProcess();
+            ProcessGenerator::stop();
+            tableSize = ScreenManager::getProcesses().size();
+        }
+        std::vector<std::string> hits, misses;
+        std::mt19937 rng(7);
+        for (int i = 0; i < 1024; ++i) {
+            hits.push_back(ScreenManager::getProcesses()[rng() % tableSize]->getName());
+            misses.push_back("missing" + std::to_string(i));
+        }
+        uint64_t n = scaled(2000);
+        size_t found = 0;
+        std::string label = std::to_string(tableSize) + " processes";
+        report("lookup", "hit, " + label, n, timeIt([&] {
+            for (uint64_t i = 0; i < n; ++i) found += getProcessByName(hits[i % hits.size()]) != nullptr;
+        }));
+        report("lookup", "miss, " + label, n, timeIt([&] {
+            for (uint64_t i = 0; i < n; ++i) found += getProcessByName(misses[i % misses.size()]) != nullptr;
+        }));
+        if (found == 0) std::cerr << "lookup: no hits\n";
+    }
+
+    void benchConfig() {
+        if (!selected("config")) return;
+        uint64_t n = scaled(5000);
+        report("config", "Config::load", n, timeIt([&] {
+            for (uint64_t i = 0; i < n; ++i) Config::load(CONFIG_PATH);
+        }));
+    }
+
+    // Steady-state churn through each policy's ready set: the cores pick in turn and
+    // each picked process is requeued, with `depth` processes waiting throughout.
+    void benchReadyQueue() {
+        if (!selected("readyqueue")) return;
+        const char* policies[] = { "fcfs", "rr", "sjf", "priority", "mlfq" };
+        for (size_t depth : { size_t{ 64 }, size_t{ 16384 } }) {
+            std::vector<Process*> procs;
+            std::mt19937 rng(11);
+            for (size_t i = 0; i < depth; ++i) {
+                Process* p = Process::create("q" + std::to_string(i), InstructionList{});
+                p->getSchedInfo().priority = static_cast<int>(rng() % SchedInfo::PRIORITY_LEVELS);
+                procs.push_back(p);
+            }
+            for (const char* name : policies) {
+                writeConfig(name);
+                std::unique_ptr<SchedulingPolicy> pol = SchedulingPolicy::create(name);
+                int cores = Config::getNumCpu();
+                uint64_t now = 1;
+                for (Process* p : procs) {
+                    p->getSchedInfo() = SchedInfo{ .priority = p->getSchedInfo().priority };
+                    pol->enqueue(p, now);
+                }
+                uint64_t n = scaled(1000000);
+                report("readyqueue", std::string(name) + ", depth " + std::to_string(depth), n, timeIt([&] {
+                    for (uint64_t i = 0; i < n; ++i) {
+                        int core = static_cast<int>(i % cores);
+                        if (core == 0) pol->onTick(++now);
+                        Process* p = pol->pickNext(core, now);
+                        p->getSchedInfo().last_core = core;
+                        if (i % 3 == 0) pol->onQuantumExpired(*p);
+                        pol->enqueue(p, now);
+                    }
+                }));
+                std::vector<Process*> drained;
+                pol->drain(drained);
+            }
+            for (Process* p : procs) Process::destroy(p);
+        }
+        writeConfig("rr");
+    }
+
+    // CommandQueue, the shell-to-scheduler path: producers post while one thread drains.
+    void benchCommandQueue() {
+        if (!selected("commandqueue")) return;
+        unsigned maxProducers = std::max(2u, std::min(8u, std::thread::hardware_concurrency()));
+        for (unsigned producers = 1; producers <= maxProducers; producers *= 2) {
+            CommandQueue queue;
+            uint64_t perProducer = scaled(200000) / producers;
+            uint64_t total = perProducer * producers;
+            std::atomic<uint64_t> ran{ 0 };
+            std::atomic<bool> go{ false };
+            std::vector<std::thread> threads;
+            for (unsigned t = 0; t < producers; ++t) {
+                threads.emplace_back([&] {
+                    while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                    for (uint64_t i = 0; i < perProducer; ++i) {
+                        queue.post([&ran] { ran.fetch_add(1, std::memory_order_relaxed); });
+                    }
+                });
+            }
+            auto elapsed = timeIt([&] {
+                go.store(true, std::memory_order_release);
+                while (ran.load(std::memory_order_relaxed) < total) {
+                    if (queue.drain() == 0) std::this_thread::yield();
+                }
+            });
+            for (auto& t : threads) t.join();
+            report("commandqueue", std::to_string(producers) + (producers == 1 ? " producer" : " producers"), total, elapsed);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) filter = argv[++i];
+        else if (arg == "--scale" && i + 1 < argc) scale = std::atof(argv[++i]);
+        else {
+            std::cerr << "Usage: microbench [--filter <substring>] [--scale <factor>]\n";
+            return 2;
+        }
+    }
+    if (scale <= 0) scale = 1.0;
+
+    // the emulator reports on std::cout; keep stdout for the results
+    std::streambuf* console = std::cout.rdbuf(std::cerr.rdbuf());
+    if (!writeConfig("rr")) {
+        std::cout.rdbuf(console);
+        std::cerr << "Cannot write " << CONFIG_PATH << "\n";
+        return 1;
+    }
+    MemoryManager::initialize();
+
+    std::printf("{\"bench\":\"meta\",\"suite\":\"csopesy-microbench\",\"format\":1,\"threads\":%u,\"scale\":%.3f}\n",
+        std::thread::hardware_concurrency(), scale);
+    benchExecute();
+    benchGenerate();
+    benchLookup();
+    benchConfig();
+    benchReadyQueue();
+    benchCommandQueue();
+
+    ScreenManager::replaceProcesses({});
+    MemoryManager::shutdown();
+    std::cout.rdbuf(console);
+    std::remove(CONFIG_PATH);
+    std::remove(STORE_PATH);
+    return 0;
+}
@@ -2,9 +2,17 @@
 #include <string>
 #include <sstream>
 #include <vector>
+#include <thread>
+#include <cstdlib>
 #include "Config.h"
 #include "ScreenManager.h"
 #include "Scheduler.h"
+#include "MemoryPool.h"
+#include "MemoryManager.h"
+#include "Checkpoint.h"
+#include "Trace.h"
+#include "PerfCounters.h"
+#include "Metrics.h"
 
 std::vector<std::string> splitCommand(const std::string& cmd) {
     std::istringstream iss(cmd);
@@ -16,7 +24,9 @@ std::vector<std::string> splitCommand(const std::string& cmd) {
     return tokens;
 }
 
-int main() {
+// The command shell runs on its own thread so that a slow command or a blocking read
+// never holds up the scheduler; anything that changes scheduler state is posted to it.
+void runShell() {
     std::string input;
     bool initialized = false;
 
@@ -42,10 +52,6 @@ int main() {
 
     while (true) {
 
-        Scheduler::tick(); // ticks!
-
-
-
         std::cout << "> ";
 
         std::getline(std::cin, input);
@@ -80,8 +86,12 @@ int main() {
 
 
 
+            Scheduler::shutdown(); // nothing may read the config while it is reloaded
+
             if (!Config::load("config.txt")) {
 
+                initialized = false;
+
                 std::cout << "Initialization failed.\n";
 
                 continue;
@@ -90,6 +100,16 @@ int main() {
 
             Config::printSummary();
 
+            if (!Scheduler::initialize()) { // cores start ticking from here
+
+                initialized = false;
+
+                std::cout << "Initialization failed.\n";
+
+                continue;
+
+            }
+
             initialized = true;
 
         }
@@ -202,6 +222,186 @@ int main() {
 
         }
 
+        else if (cmd == "alloc-stats") {
+
+            AllocatorStats::print();
+
+        }
+
+        else if (cmd == "vmstat") {
+
+            MemoryManager::printVmstat();
+
+        }
+
+        else if (cmd == "checkpoint" || cmd == "restore") {
+
+            if (!initialized) {
+
+                std::cout << "Error: Run 'initialize' first.\n";
+
+                continue;
+
+            }
+
+            std::string path = tokens.size() >= 2 ? tokens[1] : Checkpoint::DEFAULT_PATH;
+
+            if (cmd == "checkpoint") Checkpoint::save(path);
+
+            else if (!Checkpoint::restore(path) && !Scheduler::isBooted()) initialized = false;
+
+        }
+
+        else if (cmd == "trace") {
+
+            std::string sub = tokens.size() >= 2 ? tokens[1] : "";
+
+            std::string path = tokens.size() >= 3 ? tokens[2] : Trace::DEFAULT_PATH;
+
+            if (sub == "analyze") {
+
+                Trace::analyze(path, tokens.size() >= 4 ? tokens[3] : "");
+
+                continue;
+
+            }
+
+            if (sub != "start" && sub != "stop" && sub != "replay") {
+
+                std::cout << "Usage: trace start [file] | trace stop | trace replay [file] | trace analyze [file] [csv-prefix]\n";
+
+                continue;
+
+            }
+
+            if (!initialized) {
+
+                std::cout << "Error: Run 'initialize' first.\n";
+
+                continue;
+
+            }
+
+            if (sub == "start") {
+
+                if (Scheduler::startTrace(path)) std::cout << "Recording scheduling events to " << path << ".\n";
+
+            }
+
+            else if (sub == "stop") Scheduler::stopTrace();
+
+            else if (Trace::replay(path) != ReplayResult::REJECTED) initialized = false; // the scheduler is shut down
+
+        }
+
+        else if (cmd == "perf-stats") {
+
+            if (tokens.size() >= 2 && tokens[1] == "-r") {
+
+                Scheduler::call([] { PerfCounters::reset(); }); // between ticks, while no core is counting
+
+                std::cout << "Execution profile reset.\n";
+
+            }
+
+            else {
+
+                PerfCounters::print();
+
+            }
+
+        }
+
+        else if (cmd == "idle-stats") {
+
+            if (tokens.size() >= 2 && tokens[1] == "-r") {
+
+                Scheduler::resetIdleStats();
+
+                std::cout << "Idle statistics reset.\n";
+
+            }
+
+            else {
+
+                Scheduler::printIdleStats();
+
+            }
+
+        }
+
+        else if (cmd == "cores") {
+
+            if (tokens.size() == 1) {
+
+                std::cout << "Cores: " << Config::getNumCpu() << " (" << Scheduler::getBusyCores() << " busy)\n";
+
+                continue;
+
+            }
+
+            int count = tokens.size() == 2 ? std::atoi(tokens[1].c_str()) : 0;
+
+            if (count < 1 || count > Config::MAX_NUM_CPU) {
+
+                std::cout << "Usage: cores [1-" << Config::MAX_NUM_CPU << "]\n";
+
+                continue;
+
+            }
+
+            if (Scheduler::resizeCores(count)) Config::setNumCpu(count);
+
+        }
+
+        else if (cmd == "topology") {
+
+            Scheduler::printTopology();
+
+        }
+
+        else if (cmd == "metrics") {
+
+            std::string sub = tokens.size() >= 2 ? tokens[1] : "";
+
+            if (sub.empty()) Metrics::printStatus();
+
+            else if (sub == "show") std::cout << Metrics::render();
+
+            else if (sub == "stop") {
+
+                Metrics::stop();
+
+                std::cout << "Metrics export stopped.\n";
+
+            }
+
+            else if (sub == "serve" && tokens.size() == 3) {
+
+                int port = std::atoi(tokens[2].c_str());
+
+                if (port <= 0 || port > 65535) std::cout << "Error: Invalid port '" << tokens[2] << "'\n";
+
+                else Metrics::serve(port);
+
+            }
+
+            else if (sub == "file" && (tokens.size() == 3 || tokens.size() == 4)) {
+
+                int interval = tokens.size() == 4 ? std::atoi(tokens[3].c_str()) : Metrics::DEFAULT_INTERVAL_MS;
+
+                Metrics::writeTo(tokens[2], interval);
+
+            }
+
+            else {
+
+                std::cout << "Usage: metrics [show | serve <port> | file <path> [interval-ms] | stop]\n";
+
+            }
+
+        }
+
         else {
 
             std::cout << "Unknown command: " << cmd << " >:( \n";
@@ -214,6 +414,16 @@ int main() {
 
 
 
+}
+
+int main() {
+    std::thread shell(runShell);
+    shell.join();
+
+    Metrics::stop();
+    Checkpoint::wait();
+    Scheduler::shutdown();
+
     std::cout << "Thanks!\n";
 
     return 0;
@@ -0,0 +1,720 @@
+// Behavior tests for the emulator's subsystems: checkpoint save and restore, trace
+// record and replay, the leveled run queues, demand paging and the backing store,
+// and host topology placement.
+//
+// Not part of CSOPESY_MCO1.vcxproj. Linux build, from the repository root, linking
+// every translation unit of the emulator except main.cpp:
+//
+//   g++ -std=c++20 -O1 -pthread -I. $(ls *.cpp | grep -v '^main\.cpp$') tests/SubsystemTests.cpp -o subsystem-tests
+//   ./subsystem-tests [--filter <substring>] [--verbose]
+//
+// Prints one PASS or FAIL line per test and exits non-zero when any check failed.
+// Scratch files (config, checkpoint, traces, backing store) go to the working
+// directory and are removed at the end. The checkpoint test runs in real time and
+// takes about two seconds.
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include "../BackingStore.h"
+#include "../Checkpoint.h"
+#include "../Config.h"
+#include "../MemoryManager.h"
+#include "../Process.h"
+#include "../RunQueue.h"
+#include "../Scheduler.h"
+#include "../SchedulingPolicy.h"
+#include "../ScreenManager.h"
+#include "../Topology.h"
+#include "../Trace.h"
+
+namespace {
+    constexpr const char* CONFIG_PATH = "subsystem-tests-config.txt";
+    constexpr const char* STORE_PATH = "subsystem-tests-backing-store.bin";
+    constexpr const char* SLOTS_PATH = "subsystem-tests-slots.bin";
+    constexpr const char* CHECKPOINT_PATH = "subsystem-tests.ckpt";
+    constexpr const char* EMPTY_PATH = "subsystem-tests-empty.ckpt";
+    constexpr const char* TRACE_PATH = "subsystem-tests.trace";
+
+    std::string filter;
+    std::string current;
+    int failures = 0;
+
+    void check(bool ok, const char* what, int line) {
+        if (ok) return;
+        failures++;
+        std::printf("  %s:%d: %s\n", current.c_str(), line, what);
+    }
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+
+    bool writeConfig(const std::string& extra) {
+        std::ofstream out(CONFIG_PATH, std::ios::trunc);
+        out << "num-cpu 2\n"
+            << "scheduler rr\n"
+            << "quantum-cycles 3\n"
+            << "batch-process-freq 1\n"
+            << "min-ins 20\n"
+            << "max-ins 60\n"
+            << "delay-per-exec 0\n"
+            << "random-seed 7\n"
+            << "max-overall-mem 1024\n"
+            << "mem-per-frame 256\n"
+            << "min-mem-per-proc 1024\n"
+            << "max-mem-per-proc 2048\n"
+            << "backing-store " << STORE_PATH << "\n"
+            << extra;
+        out.close();
+        return static_cast<bool>(out) && Config::load(CONFIG_PATH);
+    }
+
+    // Boots the scheduler under the loaded config with no processes at all. A stopped
+    // scheduler keeps what was on its cores for the next boot, so restoring a
+    // checkpoint taken before the first arrival is the way to drop what a previous
+    // test left behind.
+    bool emptyScheduler() {
+        return Checkpoint::restore(EMPTY_PATH);
+    }
+
+    Process* queued(int priority, int lastCore) {
+        Process* p = Process::create("q", InstructionList{});
+        p->getSchedInfo().priority = priority;
+        p->getSchedInfo().last_core = lastCore;
+        return p;
+    }
+
+    // ---------- Checkpoint ----------
+
+    // Everything a checkpoint promises to bring back, with processes named rather than
+    // pointed to. Runs on the scheduler thread, between two ticks. seq is left out: the
+    // policy renumbers it on restore, keeping the order.
+    std::string describeState() {
+        std::ostringstream out;
+        {
+            SchedulerState s;
+            Scheduler::captureState(s);
+            out << "tick " << s.tick << " next " << s.nextProcessId << " counter " << s.tickCounter << " running "
+                << s.running << " finished " << s.finishedCount << " waiting " << s.totalWaiting << " turnaround "
+                << s.totalTurnaround << "\n";
+            for (const auto& c : s.onCores) {
+                out << "core " << c.core << " " << c.process->getName() << " budget " << c.slot.budget << " delay "
+                    << c.slot.delayLeft << "\n";
+            }
+            for (const auto& q : s.ready) out << "ready " << q.process->getName() << " " << q.queue << " " << q.level << "\n";
+            for (const auto& [p, wake] : s.sleeping) out << "sleeping " << p->getName() << " " << wake << "\n";
+
+            for (Process* p : ScreenManager::getProcesses()) {
+                ProcessState st;
+                p->saveState(st);
+                const SchedInfo& si = st.sched;
+                out << "process " << p->getName() << " line " << st.current_line << "/" << p->getTotalLines()
+                    << " finished " << st.finished << " for " << st.for_level << " " << st.for_body_pending;
+                for (int it : st.for_iter) out << " " << it;
+                out << " pid " << si.pid << " priority " << si.priority << " level " << si.level << " arrival "
+                    << si.arrival_tick << " ready " << si.ready_since << " waited " << si.waiting_ticks << " core "
+                    << si.last_core << "\n";
+                for (const auto& [name, value] : st.variables) out << "  var " << name << "=" << value << "\n";
+                for (const std::string& line : p->getLogs()) out << "  log " << line << "\n";
+                std::vector<uint32_t> pages;
+                std::vector<int32_t> inFrame;
+                std::vector<uint8_t> data;
+                MemoryManager::savePages(p->getMemory(), pages, inFrame, data);
+                for (size_t i = 0; i < pages.size(); ++i) out << "  page " << pages[i] << " frame " << inFrame[i] << "\n";
+                out << "  bytes";
+                for (uint8_t b : data) out << " " << static_cast<int>(b);
+                out << "\n";
+            }
+        }
+        return out.str();
+    }
+
+    // The state at the tick boundary the checkpoint was taken on must be the state at
+    // the first boundary after restoring it. Both descriptions run at those boundaries:
+    // the first in the same command as the capture, the second queued while no
+    // scheduler runs, so the restored one drains it before its first tick.
+    void testCheckpointRoundTrip() {
+        CHECK(writeConfig("time-mode real\nscheduler mlfq\n"));
+        CHECK(emptyScheduler());
+        Scheduler::start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+        Scheduler::stop();
+
+        std::string saved;
+        Scheduler::call([&] {
+            CHECK(Checkpoint::save(CHECKPOINT_PATH));
+            saved = describeState();
+        });
+        CHECK(!ScreenManager::getProcesses().empty());
+
+        std::string restored;
+        Scheduler::shutdown();
+        Scheduler::post([&] { restored = describeState(); });
+        CHECK(Checkpoint::restore(CHECKPOINT_PATH));
+        Scheduler::call([] {});
+        CHECK(saved == restored);
+        if (saved != restored) {
+            std::istringstream a(saved), b(restored);
+            std::string la, lb;
+            while (std::getline(a, la) && std::getline(b, lb)) {
+                if (la == lb) continue;
+                std::printf("    saved:    %s\n    restored: %s\n", la.c_str(), lb.c_str());
+                break;
+            }
+        }
+        Scheduler::shutdown();
+    }
+
+    // A checkpoint that is not there, or not one, leaves the processes alone.
+    void testCheckpointRejectsBadFiles() {
+        CHECK(writeConfig("time-mode virtual\n"));
+        {
+            std::ofstream junk(CHECKPOINT_PATH, std::ios::trunc | std::ios::binary);
+            junk << "not a checkpoint";
+        }
+        CHECK(!Checkpoint::restore(CHECKPOINT_PATH));
+        CHECK(!Checkpoint::restore("subsystem-tests-missing.ckpt"));
+        Scheduler::shutdown();
+    }
+
+    // ---------- Trace ----------
+
+    void recordTrace(const std::string& scheduler) {
+        CHECK(writeConfig("time-mode virtual\nscheduler " + scheduler + "\n"));
+        CHECK(emptyScheduler());
+        CHECK(Scheduler::startTrace(TRACE_PATH));
+        Scheduler::start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        Scheduler::stop();
+        Scheduler::stopTrace();
+    }
+
+    void testTraceReplay(const std::string& scheduler) {
+        recordTrace(scheduler);
+
+        TraceHeader header;
+        std::vector<TraceRecord> records;
+        CHECK(Trace::load(TRACE_PATH, header, records));
+        CHECK(header.endTick > header.startTick);
+        bool dispatched = std::any_of(records.begin(), records.end(),
+            [](const TraceRecord& r) { return r.type == TraceEvent::DISPATCH; });
+        CHECK(dispatched);
+
+        // re-runs under the replay policy and compares event by event
+        CHECK(Trace::replay(TRACE_PATH) == ReplayResult::MATCHED);
+        CHECK(Trace::compare(TRACE_PATH, TRACE_PATH));
+        std::remove((std::string(TRACE_PATH) + ".replay").c_str());
+    }
+
+    void testTraceReplayRr() { testTraceReplay("rr"); }
+    void testTraceReplayMlfq() { testTraceReplay("mlfq"); }
+
+    // A replay leaves the scheduler shut down; initialize brings it back with the
+    // replayed processes, and the shell thread can page for a process again.
+    void testReplayThenContinue() {
+        recordTrace("rr");
+        CHECK(Trace::replay(TRACE_PATH) == ReplayResult::MATCHED);
+        std::remove((std::string(TRACE_PATH) + ".replay").c_str());
+        uint64_t end = Scheduler::getCurrentTick();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        CHECK(Scheduler::getCurrentTick() == end);
+
+        auto linesRun = [](size_t count) {
+            uint64_t lines = 0;
+            std::vector<Process*> procs = ScreenManager::getProcesses();
+            for (size_t i = 0; i < count && i < procs.size(); ++i) {
+                ProcessState st;
+                procs[i]->saveState(st);
+                lines += st.current_line;
+            }
+            return lines;
+        };
+        CHECK(Scheduler::initialize());
+        size_t replayed = ScreenManager::getProcesses().size();
+        CHECK(replayed > 0);
+        uint64_t before = 0;
+        uint64_t after = 0;
+        Scheduler::call([&] { before = linesRun(replayed); });
+        Scheduler::start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        Scheduler::stop();
+        CHECK(Scheduler::getCurrentTick() > end);
+        CHECK(ScreenManager::getProcesses().size() > replayed);
+        Scheduler::call([&] { after = linesRun(replayed); });
+        CHECK(after > before); // the replayed processes carry on
+
+        Process* p = Process::create("manual", InstructionList{});
+        MemoryManager::attach(p->getMemory(), 1024);
+        Instruction write;
+        write.type = Instruction::WRITE;
+        write.args.assign({ "0x10", "5" });
+        p->executeInstruction(write);
+        Instruction read;
+        read.type = Instruction::READ;
+        read.args.assign({ "x", "0x10" });
+        p->executeInstruction(read);
+        ProcessState st;
+        p->saveState(st);
+        CHECK((st.variables == std::vector<std::pair<std::string, uint16_t>>{ { "x", 5 } }));
+        Scheduler::call([p] { MemoryManager::release(p->getMemory()); });
+        Process::destroy(p);
+        Scheduler::shutdown();
+    }
+
+    // ---------- Run queues ----------
+
+    void testRunQueueBasics() {
+        RunQueue q;
+        Process* a = queued(0, -1);
+        Process* b = queued(0, -1);
+        Process* c = queued(0, -1);
+        CHECK(q.empty() && q.bestLevel() == -1 && q.pop() == nullptr);
+        q.push(a, 5);
+        q.push(b, 2);
+        q.push(c, 5);
+        CHECK(q.size() == 3 && q.bestLevel() == 2);
+        CHECK(q.occupancy() == (RunQueue::bitFor(2) | RunQueue::bitFor(5)));
+        CHECK(q.head(5) == a);
+        q.mergeInto(1); // level order, then FIFO within a level
+        CHECK(q.occupancy() == RunQueue::bitFor(1));
+        CHECK(q.pop() == b && q.pop() == a && q.pop() == c && q.empty());
+        for (Process* p : { a, b, c }) Process::destroy(p);
+    }
+
+    void testRunQueuePickAndSteal() {
+        PriorityPolicy pol(3, 5, 1000000);
+        Process* low = queued(5, 0);
+        Process* high = queued(2, 2);
+        pol.enqueue(low, 0);
+        pol.enqueue(high, 0);
+        CHECK(pol.size() == 2);
+        CHECK(pol.pickNext(0, 0) == high); // the best level anywhere beats the own queue
+        CHECK(pol.pickNext(0, 0) == low);
+        CHECK(pol.pickNext(0, 0) == nullptr && pol.empty());
+
+        // own queue first at the same level, then the ring
+        Process* on0 = queued(4, 0);
+        Process* on1 = queued(4, 1);
+        Process* on2 = queued(4, 2);
+        for (Process* p : { on0, on1, on2 }) pol.enqueue(p, 0);
+        CHECK(pol.pickNext(1, 0) == on1);
+        CHECK(pol.pickNext(1, 0) == on2); // core 1 steals from 2 before 0
+        CHECK(pol.pickNext(1, 0) == on0);
+
+        // a steal order replaces the ring
+        for (Process* p : { on0, on1 }) pol.enqueue(p, 0);
+        pol.setStealOrder({ { 2, 1 }, { 0, 2 }, { 1, 0 } });
+        CHECK(pol.pickNext(2, 0) == on1);
+        CHECK(pol.pickNext(2, 0) == on0);
+        pol.setStealOrder({ { 5 }, { 0 }, { 0 } }); // out of range: back to the ring
+        pol.enqueue(on0, 0);
+        pol.enqueue(on1, 0);
+        CHECK(pol.pickNext(2, 0) == on0);
+        CHECK(pol.pickNext(2, 0) == on1);
+
+        // FIFO within a level of one queue
+        Process* first = queued(3, 0);
+        Process* second = queued(3, 0);
+        pol.enqueue(first, 0);
+        pol.enqueue(second, 0);
+        CHECK(pol.pickNext(1, 0) == first && pol.pickNext(1, 0) == second);
+        for (Process* p : { low, high, on0, on1, on2, first, second }) Process::destroy(p);
+    }
+
+    void testRunQueueSetCores() {
+        PriorityPolicy pol(4, 5, 1000000);
+        std::vector<Process*> procs;
+        for (int core = 0; core < 4; ++core) {
+            for (int prio : { 1, 6, 6 }) {
+                Process* p = queued(prio, core);
+                procs.push_back(p);
+                pol.enqueue(p, 0);
+            }
+        }
+        auto levels = [&] {
+            std::vector<SchedulingPolicy::Queued> q;
+            uint64_t cursor = 0;
+            pol.save(q, cursor);
+            return q;
+        };
+        pol.setCores(2);
+        CHECK(pol.size() == procs.size());
+        std::vector<SchedulingPolicy::Queued> after = levels();
+        CHECK(after.size() == procs.size());
+        for (const auto& q : after) {
+            CHECK(q.queue >= 0 && q.queue < 2);
+            CHECK(q.level == q.process->getSchedInfo().priority); // levels survive the move
+        }
+
+        pol.setCores(6); // new cores start empty and steal
+        CHECK(pol.size() == procs.size());
+        std::vector<Process*> order;
+        while (Process* p = pol.pickNext(5, 0)) order.push_back(p);
+        CHECK(order.size() == procs.size());
+        for (size_t i = 0; i < 4; ++i) CHECK(order[i]->getSchedInfo().priority == 1);
+        for (size_t i = 4; i < order.size(); ++i) CHECK(order[i]->getSchedInfo().priority == 6);
+
+        pol.setCores(0); // clamped to one queue
+        for (Process* p : procs) pol.enqueue(p, 0);
+        pol.setCores(1);
+        CHECK(pol.size() == procs.size());
+        for (Process* p : procs) Process::destroy(p);
+    }
+
+    // Aging counts from each process's own ready tick, one level per interval waited.
+    void testPriorityAging() {
+        PriorityPolicy pol(1, 5, 10);
+        Process* a = queued(5, 0);
+        Process* b = queued(4, 0);
+        a->getSchedInfo().ready_since = 0;
+        b->getSchedInfo().ready_since = 9;
+        pol.enqueue(a, 0);
+        pol.enqueue(b, 9);
+        auto levelOf = [&](Process* p) {
+            std::vector<SchedulingPolicy::Queued> q;
+            uint64_t cursor = 0;
+            pol.save(q, cursor);
+            for (const auto& e : q) {
+                if (e.process == p) return e.level;
+            }
+            return -1;
+        };
+        for (uint64_t t = 1; t <= 9; ++t) pol.onTick(t);
+        CHECK(levelOf(a) == 5 && levelOf(b) == 4);
+        pol.onTick(10);
+        CHECK(levelOf(a) == 4 && levelOf(b) == 4); // b has waited one tick, not an interval
+        for (uint64_t t = 11; t <= 18; ++t) pol.onTick(t);
+        CHECK(levelOf(a) == 4 && levelOf(b) == 4);
+        pol.onTick(19);
+        CHECK(levelOf(a) == 4 && levelOf(b) == 3);
+        pol.onTick(20);
+        CHECK(levelOf(a) == 3);
+        pol.onTick(60); // skipped ticks: several levels at once, earliest to reach 0 first
+        CHECK(levelOf(a) == 0 && levelOf(b) == 0);
+        CHECK(pol.pickNext(0, 60) == b && pol.pickNext(0, 60) == a);
+        Process::destroy(a);
+        Process::destroy(b);
+    }
+
+    // ---------- Paging ----------
+
+    void touch(AddressSpace& as, uint32_t page, uint64_t tick) {
+        MemoryManager::beginTick(tick);
+        uint16_t value = 0;
+        while (!MemoryManager::tryRead(as, page * MemoryManager::getFrameSize(), value)) {
+            if (MemoryManager::serviceFault(as) != FaultResult::SERVICED) {
+                check(false, "serviceFault", __LINE__);
+                return;
+            }
+        }
+    }
+
+    // Four frames, pages 0-3 loaded in order, page 0 used again, then page 4 faults.
+    int victimUnder(const std::string& replacement) {
+        Scheduler::shutdown();
+        CHECK(writeConfig("page-replacement " + replacement + "\n"));
+        CHECK(MemoryManager::initialize());
+        AddressSpace as;
+        MemoryManager::attach(as, 8 * MemoryManager::getFrameSize());
+        for (uint32_t page = 0; page < 4; ++page) touch(as, page, page + 1);
+        touch(as, 0, 5);
+        touch(as, 4, 6);
+        int victim = -1;
+        int resident = 0;
+        for (uint32_t page = 0; page < 5; ++page) {
+            if (as.pages[page].frame < 0) victim = static_cast<int>(page);
+            else resident++;
+        }
+        CHECK(resident == 4);
+        MemoryManager::release(as);
+        MemoryManager::shutdown();
+        return victim;
+    }
+
+    void testFifoReplacement() { CHECK(victimUnder("fifo") == 0); }
+    void testLruReplacement() { CHECK(victimUnder("lru") == 1); }
+
+    // Written pages go to the store when evicted and come back intact.
+    void testPageOutAndIn() {
+        Scheduler::shutdown();
+        CHECK(writeConfig("page-replacement fifo\n"));
+        CHECK(MemoryManager::initialize());
+        uint32_t frame = MemoryManager::getFrameSize();
+        AddressSpace as;
+        MemoryManager::attach(as, 12 * frame);
+        VmCounters before = MemoryManager::getCounters();
+        for (uint32_t page = 0; page < 12; ++page) {
+            MemoryManager::beginTick(page + 1);
+            uint16_t value = static_cast<uint16_t>(0x1000 + page);
+            while (!MemoryManager::tryWrite(as, page * frame + 2, value)) {
+                CHECK(MemoryManager::serviceFault(as) == FaultResult::SERVICED);
+            }
+        }
+        for (uint32_t page = 0; page < 12; ++page) {
+            MemoryManager::beginTick(page + 20);
+            uint16_t value = 0;
+            while (!MemoryManager::tryRead(as, page * frame + 2, value)) {
+                CHECK(MemoryManager::serviceFault(as) == FaultResult::SERVICED);
+            }
+            CHECK(value == 0x1000 + page);
+        }
+        VmCounters after = MemoryManager::getCounters();
+        CHECK(after.pageOuts > before.pageOuts);
+        CHECK(after.pageIns > before.pageIns);
+        CHECK(after.storePages >= 8);
+
+        // an address past the allocation is a violation, not a fault
+        bool threw = false;
+        try {
+            uint16_t value = 0;
+            MemoryManager::tryRead(as, 12 * frame, value);
+        }
+        catch (const std::out_of_range&) {
+            threw = true;
+        }
+        CHECK(threw);
+        MemoryManager::release(as);
+        MemoryManager::shutdown();
+    }
+
+    // A backing store that cannot be created fails initialize instead of every eviction.
+    void testMissingBackingStore() {
+        CHECK(writeConfig("backing-store subsystem-tests-missing-dir/store.bin\n"));
+        CHECK(!Scheduler::initialize());
+        CHECK(!Scheduler::isBooted());
+        CHECK(writeConfig(""));
+        CHECK(Scheduler::initialize());
+        CHECK(Scheduler::isBooted());
+        Scheduler::shutdown();
+    }
+
+    // With the scheduler shut down there are no frames; a shell-thread access must fail,
+    // not wait for a frame that will never come.
+    void testAccessWithoutFrames() {
+        Scheduler::shutdown();
+        Process* p = Process::create("manual", InstructionList{});
+        MemoryManager::attach(p->getMemory(), 1024);
+        Instruction write;
+        write.type = Instruction::WRITE;
+        write.args.assign({ "0x10", "5" });
+        p->executeInstruction(write);
+        std::vector<std::string> logs = p->getLogs();
+        CHECK(!logs.empty() && logs.back().find("no physical memory") != std::string::npos);
+        MemoryManager::release(p->getMemory());
+        Process::destroy(p);
+    }
+
+    void testBackingStoreGrowth() {
+        const size_t slotSize = 256;
+        BackingStore store;
+        CHECK(store.open(SLOTS_PATH, slotSize));
+        size_t initial = store.getCapacity();
+        size_t count = initial * 3 + 5; // past two doublings
+        std::vector<int32_t> slots;
+        std::vector<uint8_t> page(slotSize);
+        for (size_t i = 0; i < count; ++i) {
+            int32_t s = store.allocateSlot();
+            CHECK(s >= 0);
+            std::fill(page.begin(), page.end(), static_cast<uint8_t>(i * 7));
+            page[0] = static_cast<uint8_t>(i >> 8);
+            store.write(s, page.data());
+            slots.push_back(s);
+        }
+        CHECK(store.getSlotsInUse() == count);
+        CHECK(store.getCapacity() >= count);
+        std::vector<int32_t> unique = slots;
+        std::sort(unique.begin(), unique.end());
+        CHECK(std::unique(unique.begin(), unique.end()) == unique.end());
+        bool intact = true;
+        for (size_t i = 0; i < count; ++i) {
+            store.read(slots[i], page.data());
+            intact = intact && page[0] == static_cast<uint8_t>(i >> 8) && page[1] == static_cast<uint8_t>(i * 7) &&
+                page[slotSize - 1] == static_cast<uint8_t>(i * 7);
+        }
+        CHECK(intact); // the remaps kept what was written before them
+
+        store.freeSlot(slots[3]);
+        CHECK(store.getSlotsInUse() == count - 1);
+        CHECK(store.allocateSlot() == slots[3]); // freed slots are reused before the file grows
+        store.close();
+        std::remove(SLOTS_PATH);
+    }
+
+    // A file that cannot grow keeps what it holds: allocateSlot fails, the slots stay mapped.
+    void testBackingStoreGrowthFails() {
+        const size_t slotSize = 256;
+        BackingStore store;
+        CHECK(store.open(SLOTS_PATH, slotSize));
+        std::vector<uint8_t> page(slotSize);
+        std::vector<int32_t> slots;
+        while (store.getSlotsInUse() < store.getCapacity()) {
+            int32_t s = store.allocateSlot();
+            std::fill(page.begin(), page.end(), static_cast<uint8_t>(s));
+            store.write(s, page.data());
+            slots.push_back(s);
+        }
+
+        rlimit saved;
+        getrlimit(RLIMIT_FSIZE, &saved);
+        rlimit capped = saved;
+        capped.rlim_cur = store.getCapacity() * slotSize; // ftruncate past this fails with EFBIG
+        auto oldHandler = std::signal(SIGXFSZ, SIG_IGN);
+        setrlimit(RLIMIT_FSIZE, &capped);
+        CHECK(store.allocateSlot() == -1);
+        setrlimit(RLIMIT_FSIZE, &saved);
+        std::signal(SIGXFSZ, oldHandler);
+
+        CHECK(store.isOpen());
+        bool intact = true;
+        for (int32_t s : slots) {
+            store.read(s, page.data());
+            intact = intact && page[0] == static_cast<uint8_t>(s) && page[slotSize - 1] == static_cast<uint8_t>(s);
+        }
+        CHECK(intact);
+        CHECK(store.allocateSlot() >= 0); // and it grows once it can
+        store.close();
+        std::remove(SLOTS_PATH);
+    }
+
+    // ---------- Topology ----------
+
+    void testParseCpuList() {
+        std::vector<int> cpus;
+        CHECK(Topology::parseCpuList("0,2,4-7", cpus));
+        CHECK((cpus == std::vector<int>{ 0, 2, 4, 5, 6, 7 }));
+        CHECK(Topology::parseCpuList("3", cpus) && cpus == std::vector<int>{ 3 });
+        CHECK(Topology::parseCpuList("5-5", cpus) && cpus == std::vector<int>{ 5 });
+        CHECK(Topology::parseCpuList("1023", cpus));
+        for (const char* bad : { "", ",", "1,", ",1", "1,,2", "3-1", "1-", "-1", "a", "1a", "1-2x", "1024", "0-1024" }) {
+            if (Topology::parseCpuList(bad, cpus)) {
+                std::printf("  accepted '%s'\n", bad);
+                failures++;
+            }
+        }
+    }
+
+    void testPlacement() {
+        CHECK((Topology::placement("off", {}, 3) == std::vector<int>{ -1, -1, -1 }));
+        CHECK((Topology::placement("list", { 2, 5 }, 5) == std::vector<int>{ 2, 5, 2, 5, 2 })); // wraps
+        CHECK((Topology::placement("list", {}, 2) == std::vector<int>{ -1, -1 }));
+        CHECK(Topology::placement("compact", {}, 0).empty());
+        CHECK(Topology::placement("scatter", {}, -3).empty());
+        // a longer placement extends a shorter one, so a resize never moves a core
+        std::vector<int> three = Topology::placement("list", { 4, 1, 9 }, 3);
+        std::vector<int> seven = Topology::placement("list", { 4, 1, 9 }, 7);
+        CHECK(std::equal(three.begin(), three.end(), seven.begin()));
+
+        const std::vector<HostCpu>& host = Topology::host();
+        CHECK(!host.empty());
+        for (const char* mode : { "compact", "scatter" }) {
+            std::vector<int> all = Topology::placement(mode, {}, static_cast<int>(host.size()));
+            std::vector<int> sorted = all;
+            std::sort(sorted.begin(), sorted.end());
+            std::vector<int> ids;
+            for (const HostCpu& c : host) ids.push_back(c.id);
+            std::sort(ids.begin(), ids.end());
+            CHECK(sorted == ids); // every allowed CPU once
+            std::vector<int> twice = Topology::placement(mode, {}, static_cast<int>(host.size() * 2));
+            CHECK(std::equal(all.begin(), all.end(), twice.begin() + host.size()));
+        }
+    }
+
+    void testStealOrder() {
+        CHECK(Topology::stealOrder({}).empty());
+        CHECK(Topology::stealOrder({ 0, -1 }).empty()); // not pinned: ring order
+        CHECK((Topology::stealOrder({ 0 }) == std::vector<std::vector<int>>{ {} }));
+        // CPUs the host does not have are all equally far: ring order
+        std::vector<std::vector<int>> ring = Topology::stealOrder({ 9001, 9002, 9003 });
+        CHECK((ring == std::vector<std::vector<int>>{ { 1, 2 }, { 2, 0 }, { 0, 1 } }));
+        // cores on the same CPU come first
+        std::vector<std::vector<int>> shared = Topology::stealOrder({ 9001, 9002, 9001, 9003 });
+        CHECK((shared[0] == std::vector<int>{ 2, 1, 3 }));
+        CHECK((shared[2] == std::vector<int>{ 0, 3, 1 }));
+        CHECK(Topology::distance(9001, 9001) == 0 && Topology::distance(9001, 9002) == 5);
+        for (const HostCpu& c : Topology::host()) CHECK(Topology::distance(c.id, c.id) == 0);
+    }
+
+    struct Test {
+        const char* name;
+        void (*run)();
+    };
+
+    const Test TESTS[] = {
+        { "checkpoint/round-trip", testCheckpointRoundTrip },
+        { "checkpoint/bad-files", testCheckpointRejectsBadFiles },
+        { "trace/replay-rr", testTraceReplayRr },
+        { "trace/replay-mlfq", testTraceReplayMlfq },
+        { "trace/replay-then-continue", testReplayThenContinue },
+        { "runqueue/basics", testRunQueueBasics },
+        { "runqueue/pick-steal", testRunQueuePickAndSteal },
+        { "runqueue/set-cores", testRunQueueSetCores },
+        { "runqueue/aging", testPriorityAging },
+        { "paging/fifo", testFifoReplacement },
+        { "paging/lru", testLruReplacement },
+        { "paging/out-and-in", testPageOutAndIn },
+        { "paging/missing-store", testMissingBackingStore },
+        { "paging/no-frames", testAccessWithoutFrames },
+        { "paging/store-growth", testBackingStoreGrowth },
+        { "paging/store-growth-fails", testBackingStoreGrowthFails },
+        { "topology/parse-cpu-list", testParseCpuList },
+        { "topology/placement", testPlacement },
+        { "topology/steal-order", testStealOrder },
+    };
+}
+
+int main(int argc, char** argv) {
+    bool verbose = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) filter = argv[++i];
+        else if (arg == "--verbose") verbose = true;
+        else {
+            std::cerr << "Usage: subsystem-tests [--filter <substring>] [--verbose]\n";
+            return 2;
+        }
+    }
+
+    // the emulator reports on std::cout; only the test results are shown
+    std::streambuf* console = std::cout.rdbuf();
+    std::ostringstream chatter;
+    if (!verbose) std::cout.rdbuf(chatter.rdbuf());
+
+    if (!writeConfig("time-mode virtual\n") || !Scheduler::initialize()) { // not started: nothing arrives
+        std::cerr << "Cannot initialize from " << CONFIG_PATH << "\n";
+        return 2;
+    }
+    if (!Checkpoint::save(EMPTY_PATH)) return 2;
+
+    int run = 0;
+    int failed = 0;
+    for (const Test& t : TESTS) {
+        current = t.name;
+        if (!filter.empty() && current.find(filter) == std::string::npos) continue;
+        int before = failures;
+        t.run();
+        run++;
+        if (failures != before) failed++;
+        std::printf("%s %s\n", failures == before ? "PASS" : "FAIL", t.name);
+        std::fflush(stdout);
+        chatter.str("");
+    }
+
+    Checkpoint::wait();
+    Scheduler::shutdown();
+    ScreenManager::replaceProcesses({});
+    MemoryManager::shutdown();
+    std::cout.rdbuf(console);
+    for (const char* path : { CONFIG_PATH, STORE_PATH, SLOTS_PATH, CHECKPOINT_PATH, EMPTY_PATH, TRACE_PATH }) {
+        std::remove(path);
+    }
+
+    std::printf("%d of %d tests passed\n", run - failed, run);
+    return failed == 0 ? 0 : 1;
+}